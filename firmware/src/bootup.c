@@ -17,9 +17,12 @@ extern uint32_t _ebss;
 #define CSR_MEMORY_START (uint32_t)0x30000000
 volatile uint32_t* mtimecmp_l = (uint32_t*)(CSR_MEMORY_START + 8);
 volatile uint32_t* mtimecmp_h = (uint32_t*)(CSR_MEMORY_START + 12);
-volatile uint32_t* keyboard_controller = (uint32_t*)(CSR_MEMORY_START + 16);
 volatile uint32_t* msip = (uint32_t*)(CSR_MEMORY_START + 20);
 
+#define KEYBOARD_START (uint32_t)0x10002000
+volatile uint32_t* keyboard_status = (uint32_t*)(KEYBOARD_START);
+volatile uint32_t* keyboard_event = (uint32_t*)(KEYBOARD_START + 4);
+
 void random_routine(void);
 
 // https://five-embeddev.com/code/2020/11/18/csr-access/
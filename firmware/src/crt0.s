@@ -1,7 +1,11 @@
 .section .init
 .global _start
+.global _park
 _start:
-    
+    # Only hart 0 boots, the others wait until kernel code needs them
+    csrr t0, mhartid
+    bnez t0, _park
+
     la sp, __stack_top                  # Load stack pointer
     addi sp, sp, -4
     .option push
@@ -20,3 +24,7 @@ _start:
 
 _spin:
     jal _spin
+
+_park:
+    wfi
+    j _park
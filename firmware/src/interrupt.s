@@ -3,6 +3,9 @@
 .global random_routine
 
 # Do not change unless you know what you are doing
+# Every entry must be 4 bytes, so the jumps are never compressed
+.option push
+.option norvc
 _vector_table:
     # Interrupts
     j _reserved                             # Reserved
@@ -35,6 +38,11 @@ _vector_table:
     j _reserved                             # Environment Call from S-mode
     j _reserved                             # Reserved
     j _environment_call_m_mode              # Environment Call from M-Mode
+    j _reserved                             # Instruction Page Fault
+    j _reserved                             # Load Page Fault
+    j _reserved                             # Reserved
+    j _reserved                             # Store/AMO Page Fault
+.option pop
 
 # Many of the interrupts/exceptions simply spin, doing nothing
 # That is where the user should provide software to properly handle
@@ -95,7 +103,12 @@ _store_address_misaligned:
 _store_access_fault:
     jal _store_access_fault # Write software to handle exception
 
-# Trap taken when CPU invokes ecall instruction
+# Trap taken when CPU invokes ecall instruction. mepc holds
+# the address of the ecall, return to the instruction after it
 _environment_call_m_mode:
-    jal _environment_call_m_mode # Write software to handle exception
+    csrw mscratch, t0 # Write software to handle exception
+    csrr t0, mepc
+    addi t0, t0, 4
+    csrw mepc, t0
+    csrr t0, mscratch
     mret
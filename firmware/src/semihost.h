@@ -0,0 +1,43 @@
+#ifndef SEMIHOST_H
+#define SEMIHOST_H
+
+// Semihosting registers
+#define SEMIHOST_START (unsigned int)0x10003000
+#define SEMIHOST_REG(offset) *(volatile unsigned int*)(SEMIHOST_START + (offset))
+#define SEMIHOST_COMMAND SEMIHOST_REG(0x00)
+#define SEMIHOST_ARG0 SEMIHOST_REG(0x04)
+#define SEMIHOST_ARG1 SEMIHOST_REG(0x08)
+#define SEMIHOST_ARG2 SEMIHOST_REG(0x0c)
+#define SEMIHOST_RESULT SEMIHOST_REG(0x10)
+#define SEMIHOST_RESULT_HI SEMIHOST_REG(0x14)
+
+#define SEMIHOST_EXIT 1
+#define SEMIHOST_WRITE 2
+#define SEMIHOST_TIME 3
+
+// The registers are shared, harts must not issue commands concurrently
+
+// End the run, code is reported by the host
+static inline void host_exit(unsigned int code) {
+    SEMIHOST_ARG0 = code;
+    SEMIHOST_COMMAND = SEMIHOST_EXIT;
+    while (1);
+}
+
+// Write len bytes of buf (physical address) to host stdout (1) or
+// stderr (2), returns the bytes written or -1
+static inline int host_write(int fd, const void *buf, unsigned int len) {
+    SEMIHOST_ARG0 = fd;
+    SEMIHOST_ARG1 = (unsigned int)buf;
+    SEMIHOST_ARG2 = len;
+    SEMIHOST_COMMAND = SEMIHOST_WRITE;
+    return SEMIHOST_RESULT;
+}
+
+// Host monotonic time in nanoseconds since the emulator started
+static inline unsigned long long host_time(void) {
+    SEMIHOST_COMMAND = SEMIHOST_TIME;
+    return SEMIHOST_RESULT | ((unsigned long long)SEMIHOST_RESULT_HI << 32);
+}
+
+#endif // SEMIHOST_H
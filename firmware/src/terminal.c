@@ -8,11 +8,14 @@ void init_terminal(void) {
 }
 
 void init_blue_screen(void) {
-    volatile unsigned int* buffer = GRAPHICS_BUFF;
-    int idx;
-    for (idx = 0; idx < PIXEL_MAX; idx++) {
-        buffer[idx] = BLUE_SCREEN;
-    }
+    // Let the blitter fill the screen instead of storing every pixel
+    BLITTER_DST = (unsigned int)GRAPHICS_BUFF;
+    BLITTER_DST_PITCH = WIDTH * 4;
+    BLITTER_WIDTH = WIDTH;
+    BLITTER_HEIGHT = HEIGHT;
+    BLITTER_COLOR = BLUE_SCREEN;
+    BLITTER_BPP = 4;
+    BLITTER_COMMAND = BLIT_FILL;
 }
 
 void print_str(const char* str, int len) {
@@ -18,6 +18,28 @@
 #define TEXT_BUFFER (volatile unsigned char*)(VRAM_START + 16)
 #define GRAPHICS_BUFF (volatile unsigned int*)(VRAM_START + 1360)
 
+// Blitter registers
+#define BLITTER_START (unsigned int)0x20200000
+#define BLITTER_REG(offset) *(volatile unsigned int*)(BLITTER_START + (offset))
+#define BLITTER_COMMAND BLITTER_REG(0x00)
+#define BLITTER_STATUS BLITTER_REG(0x04)
+#define BLITTER_DST BLITTER_REG(0x08)
+#define BLITTER_DST_PITCH BLITTER_REG(0x0c)
+#define BLITTER_SRC BLITTER_REG(0x10)
+#define BLITTER_SRC_PITCH BLITTER_REG(0x14)
+#define BLITTER_WIDTH BLITTER_REG(0x18)
+#define BLITTER_HEIGHT BLITTER_REG(0x1c)
+#define BLITTER_COLOR BLITTER_REG(0x20)
+#define BLITTER_BG_COLOR BLITTER_REG(0x24)
+#define BLITTER_COLOR_KEY BLITTER_REG(0x28)
+#define BLITTER_FLAGS BLITTER_REG(0x2c)
+#define BLITTER_BPP BLITTER_REG(0x30)
+
+#define BLIT_FILL 1
+#define BLIT_COPY 2
+#define BLIT_COPY_KEYED 3
+#define BLIT_GLYPH 4
+
 typedef struct {
     int cursor_index;
     
@@ -14,6 +14,43 @@
 #define SLT  8
 #define SLTU 9
 
+// RV32M
+#define MUL    10
+#define MULH   11
+#define MULHSU 12
+#define MULHU  13
+#define DIV    14
+#define DIVU   15
+#define REM    16
+#define REMU   17
+
+// Zba
+#define SH1ADD 18
+#define SH2ADD 19
+#define SH3ADD 20
+
+// Zbb
+#define ANDN   21
+#define ORN    22
+#define XNOR   23
+#define CLZ    24
+#define CTZ    25
+#define CPOP   26
+#define SEXTB  27
+#define SEXTH  28
+#define ZEXTH  29
+#define MAX    30
+#define MAXU   31
+#define MIN    32
+#define MINU   33
+#define ROL    34
+#define ROR    35
+#define REV8   36
+#define ORCB   37
+
+// Reserved encoding, executed as an illegal instruction
+#define ALU_ILLEGAL 0xff
+
 class Alu {
 public:
     Alu(void);
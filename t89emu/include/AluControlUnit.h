@@ -10,7 +10,10 @@ public:
     AluControlUnit(void);
     ~AluControlUnit();
 
-    int getAluOperation(int opcode, int funct7, int funct3);
+    // rs2 selects between the single operand Zbb instructions, and is the
+    // shift amount of immediate shifts. Returns ALU_ILLEGAL for reserved
+    // Zbb encodings
+    int getAluOperation(int opcode, int funct7, int funct3, int rs2 = 0);
 
 private:
     std::vector<int> iOperations;
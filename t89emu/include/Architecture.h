@@ -24,10 +24,40 @@
 #define ITYPE                               0b0010011
 #define RTYPE                               0b0110011
 #define PRIV                                0b1110011
+#define AMO                                 0b0101111
+#define LOAD_FP                             0b0000111
+#define STORE_FP                            0b0100111
+#define FMADD                               0b1000011
+#define FMSUB                               0b1000111
+#define FNMSUB                              0b1001011
+#define FNMADD                              0b1001111
+#define OP_FP                               0b1010011
+#define FENCE                               0b0001111
+
+// funct5 of RV32A instructions (AMO opcode)
+#define AMO_ADD                             0b00000
+#define AMO_SWAP                            0b00001
+#define AMO_LR                              0b00010
+#define AMO_SC                              0b00011
+#define AMO_XOR                             0b00100
+#define AMO_OR                              0b01000
+#define AMO_AND                             0b01100
+#define AMO_MIN                             0b10000
+#define AMO_MAX                             0b10100
+#define AMO_MINU                            0b11000
+#define AMO_MAXU                            0b11100
+
+// funct7 of RV32M instructions (RTYPE opcode)
+#define MULDIV_FUNCT7                       0b0000001
 
 #define ECALL_IMM                           0b000000000000
 #define MRET_IMM                            0b001100000010
 #define URET_IMM                            0b000000000010
+#define WFI_IMM                             0b000100000101
+#define SRET_IMM                            0b000100000010
+
+// funct7 of SFENCE.VMA (PRIV opcode)
+#define SFENCE_VMA_FUNCT7                   0b0001001
 
 #define STATUS_OK                           0xffffffff
 
@@ -0,0 +1,71 @@
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#ifndef BATCHRUNNER_H
+#define BATCHRUNNER_H
+
+#include "ElfParser.h"
+#include "Runner.h"
+
+// One firmware image and configuration to run
+struct BatchJob {
+    std::string name;
+    std::string elfPath;
+    std::string diskPath;
+    std::string keyScriptPath;
+    uint32_t numHarts = 1;
+    RunOptions options;
+};
+
+struct BatchResult {
+    std::string status;             // Stop reason, or why the job failed
+    bool hasExitCode = false;
+    uint32_t exitCode = 0;
+    uint64_t instructions = 0;
+    double seconds = 0;
+    uint64_t outputHash = 0;        // FNV-1a of the console output
+    uint64_t outputSize = 0;
+};
+
+// Runs many jobs at once, each on its own machine. Jobs are handed out to a
+// pool of worker threads in manifest order, and console output of each job
+// is captured instead of printed
+class BatchRunner {
+public:
+    // 0 workers uses one per host core
+    BatchRunner(uint32_t numWorkers);
+
+    // Read jobs from a manifest, one per line:
+    //   <elf> [name=<name>] [harts=<n>] [budget=<instructions>]
+    //         [timeout=<seconds>] [quantum=<n>] [keys=<script>] [disk=<image>]
+    // Blank lines and lines starting with # are skipped, limits a job does
+    // not set come from defaults. Returns false and prints the offending
+    // line if the manifest is malformed
+    bool loadManifest(const char *path, const RunOptions &defaults);
+
+    void addJob(const BatchJob &job);
+
+    // Run every job, returns once all of them finished
+    void run(void);
+
+    // Write the results as JSON, "-" writes to stdout
+    bool writeReport(const char *path);
+
+    // Number of jobs that did not end in a guest exit with code 0
+    uint32_t getNumFailed(void);
+
+    const std::vector<BatchJob> &getJobs(void);
+    const std::vector<BatchResult> &getResults(void);
+
+private:
+    BatchResult runJob(const BatchJob &job, ElfParser *elfParser);
+
+    static uint64_t hashOutput(const std::string &output);
+
+    uint32_t numWorkers;
+    std::vector<BatchJob> jobs;
+    std::vector<BatchResult> results;
+};
+
+#endif // BATCHRUNNER_H
@@ -0,0 +1,67 @@
+#include <stdint.h>
+#include <vector>
+
+#include "Architecture.h"
+#include "Bus.h"
+#include "MemoryDevice.h"
+#include "PlicMemoryDevice.h"
+
+#ifndef BLITTERMEMORYDEVICE_H
+#define BLITTERMEMORYDEVICE_H
+
+// Size and offsets do not change across Blitter devices
+#define BLITTER_SIZE                0x34
+
+#define BLITTER_COMMAND_OFFSET      0x00 // Write starts a command
+#define BLITTER_STATUS_OFFSET       0x04 // Read only
+#define BLITTER_DST_OFFSET          0x08
+#define BLITTER_DST_PITCH_OFFSET    0x0c // Bytes per destination row
+#define BLITTER_SRC_OFFSET          0x10
+#define BLITTER_SRC_PITCH_OFFSET    0x14 // Bytes per source row
+#define BLITTER_WIDTH_OFFSET        0x18 // Pixels
+#define BLITTER_HEIGHT_OFFSET       0x1c // Rows
+#define BLITTER_COLOR_OFFSET        0x20 // Fill/glyph foreground color
+#define BLITTER_BG_COLOR_OFFSET     0x24 // Glyph background color
+#define BLITTER_COLOR_KEY_OFFSET    0x28 // Transparent source color
+#define BLITTER_FLAGS_OFFSET        0x2c
+#define BLITTER_BPP_OFFSET          0x30 // Bytes per pixel (1, 2 or 4)
+
+// Commands
+#define BLIT_FILL                   1 // Solid rectangle fill
+#define BLIT_COPY                   2 // Rectangle copy, regions may overlap
+#define BLIT_COPY_KEYED             3 // Copy skipping color key pixels
+#define BLIT_GLYPH                  4 // Expand a 1bpp bitmap, MSB first
+
+// Status bits
+#define BLITTER_STATUS_DONE         0x1
+#define BLITTER_STATUS_ERROR        0x2
+
+// Flags
+#define BLITTER_FLAG_TRANSPARENT    0x1 // Glyph background is not drawn
+
+class BlitterMemoryDevice : public MemoryDevice {
+public:
+    BlitterMemoryDevice(uint32_t base, uint32_t size, Bus *bus,
+                        PlicMemoryDevice *plic, uint32_t irq);
+
+    uint32_t read(uint32_t addr, uint32_t size, uint32_t *readValue);
+    uint32_t write(uint32_t addr, uint32_t value, uint32_t size);
+
+private:
+    bool execute(uint32_t command);
+    bool fill(void);
+    bool copy(bool isKeyed);
+    bool glyph(void);
+
+    uint32_t getRegister(uint32_t offset);
+
+    Bus *bus;
+    PlicMemoryDevice *plic;
+    uint32_t irq;
+
+    // Host side row buffers
+    std::vector<uint8_t> srcRow;
+    std::vector<uint8_t> dstRow;
+};
+
+#endif // BLITTERMEMORYDEVICE_H
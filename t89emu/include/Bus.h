@@ -1,6 +1,7 @@
 #ifndef BUS_H
 #define BUS_H
 
+#include <mutex>
 #include <stdint.h>
 #include <vector>
 
@@ -56,11 +57,45 @@ public:
     uint32_t read(uint32_t addr, uint32_t accessSize, uint32_t *readValue);
     uint32_t write(uint32_t addr, uint32_t writeValue, uint32_t accessSize);
 
+    // Bulk transfers used by DMA capable devices, the block must fall
+    // entirely within one memory device
+    uint32_t readBlock(uint32_t addr, uint8_t *dst, uint32_t size);
+    uint32_t writeBlock(uint32_t addr, const uint8_t *src, uint32_t size);
+
+    // Word sized atomic memory operations for the A extension
+    uint32_t atomicOperation(uint32_t addr, uint32_t operation,
+                             uint32_t operand, uint32_t *readValue);
+    uint32_t compareAndSwap(uint32_t addr, uint32_t expected, uint32_t value,
+                            bool *isSwapped);
+
     int addDevice(MemoryDevice *device);
 
+    // When harts run on separate host threads, accesses to devices that
+    // are not thread safe are serialized by a shared lock. Code outside the
+    // bus that touches device state (scheduled events) takes the same lock
+    void setSerialized(bool isSerialized);
+    void lockDevices(void);
+    void unlockDevices(void);
+
+    std::vector<MemoryDevice *> &getDevices(void);
+
 private:
-    // Todo: UART, PLIC
+    // Holds the device lock while a device access is in progress
+    class DeviceGuard {
+    public:
+        DeviceGuard(Bus *bus, MemoryDevice *device);
+        ~DeviceGuard();
+
+    private:
+        Bus *bus;
+    };
+
+    // Todo: UART
     std::vector<MemoryDevice *> devices;
+
+    // Recursive so DMA devices can access other devices through the bus
+    std::recursive_mutex deviceLock;
+    bool isSerialized;
 };
 
 #endif // BUS_EXPERIMENTAL
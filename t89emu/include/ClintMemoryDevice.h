@@ -1,4 +1,7 @@
 #include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 
 #include "Architecture.h"
 #include "Csr.h"
@@ -8,28 +11,63 @@
 #define CLINTMEMORYDEVICE_H
 
 // Size and offsets do not change across Clint devices
-#define CLINT_SIZE              0x18
+#define CLINT_SIZE              0x80
+#define CLINT_MAX_HARTS         8
 
+// mcycle is the time base shared by all harts
 #define MCYCLE_OFFSET           0x0
+
+// Hart 0 registers at their original locations, aliases of the
+// first entry of the per-hart arrays
 #define MTIMECMP_OFFSET         0x8
 
 // Machine software interrupt pending bit must be
 // in memory for harts to generate software interrupts
 #define MSIP_OFFSET             0x14
 
+// Per-hart registers, hart n is at offset + n * register size
+#define MSIP_ARRAY_OFFSET       0x20
+#define MTIMECMP_ARRAY_OFFSET   0x40
+
 class ClintMemoryDevice : public MemoryDevice {
 public:
     ClintMemoryDevice(uint32_t base, uint32_t size);
     uint32_t read(uint32_t addr, uint32_t size, uint32_t *read_value);
     uint32_t write(uint32_t addr, uint32_t write_value, uint32_t size);
 
-    void nextCycle(Csr *csr);
-    bool checkInterrupts(Csr *csr);
+    // Update the pending timer/software interrupt bits of a hart, hart 0
+    // also advances mcycle
+    void nextCycle(Csr *csr, uint32_t hartId);
+
+    // Latch the pending timer/software interrupt bits of a hart into mip
+    void updatePending(Csr *csr, uint32_t hartId);
+
+    uint64_t getCycle(void);
 
-    uint32_t getInterruptType(void);
+    // Block the calling thread while a hart in WFI has no interrupt pending
+    // and enabled in mie. Returns when mcycle reaches the hart's mtimecmp,
+    // when a timer or software interrupt register is written, or when
+    // wakeAll() is called, so callers check the hart again. Returns at once
+    // if isCancelled is set
+    void waitForInterrupt(Csr *csr, uint32_t hartId,
+                          const std::atomic<bool> &isCancelled);
+
+    // Wake every waiting hart
+    void wakeAll(void);
+
+    // Returns true and the interrupt to take if one is pending and enabled
+    bool checkInterrupts(Csr *csr, uint32_t hartId, uint32_t *interruptType);
 
 private:
-    uint32_t interruptType; // Used when taking trap
+    // Offset of a register in mem, resolving the hart 0 aliases
+    uint32_t getRegisterOffset(uint32_t addr);
+
+    // Waiting harts sleep until wakeGeneration changes. Hart 0 wakes them
+    // once mcycle reaches wakeCycle, the earliest mtimecmp they wait for
+    std::mutex waitLock;
+    std::condition_variable waitCondition;
+    uint64_t wakeGeneration;
+    uint64_t wakeCycle;
 };
 
 #endif // CLINTMEMORYDEVICE_H
\ No newline at end of file
@@ -0,0 +1,33 @@
+#include <stdint.h>
+#include <vector>
+
+#ifndef CODECOVERAGE_H
+#define CODECOVERAGE_H
+
+#include "Smp.h"
+
+// Line coverage of firmware in ROM. While the machine runs, each hart only
+// marks the ROM halfwords it executes, see Mcu::setExecutionMap. The marks
+// are mapped to source lines once at the end, through the DWARF line table
+// of the firmware. Code run from RAM is not covered
+class CodeCoverage {
+public:
+    // Start marking executed instructions on every hart of smp
+    CodeCoverage(Smp *smp);
+    ~CodeCoverage();
+
+    // Write the line coverage of the firmware at elfPath as an lcov
+    // tracefile. The firmware needs debug information, and its sources must
+    // be readable at the paths it records. Returns false on failure
+    bool writeLcov(const char *elfPath, const char *lcovPath);
+
+private:
+    // True if any instruction in [start, end) executed
+    bool isExecuted(uint32_t start, uint32_t end);
+
+    std::vector<uint8_t> executionMap;
+    uint32_t romBase;
+    Smp *smp;
+};
+
+#endif // CODECOVERAGE_H
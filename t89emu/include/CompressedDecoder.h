@@ -0,0 +1,41 @@
+#include <stdint.h>
+
+#include "Architecture.h"
+
+#ifndef COMPRESSEDDECODER_H
+#define COMPRESSEDDECODER_H
+
+// Expands RV32C instructions to the 32-bit instruction they encode, so the
+// rest of the core only ever decodes 32-bit instructions
+class CompressedDecoder {
+public:
+    CompressedDecoder(void);
+    ~CompressedDecoder();
+
+    // Instructions with the low two bits set are 32 bits long
+    static inline bool isCompressed(uint32_t instruction) {
+        return (instruction & 0b11) != 0b11;
+    }
+
+    // Returns the equivalent 32-bit instruction, or 0 (an illegal
+    // instruction) if the compressed instruction is reserved or unsupported
+    uint32_t expand(uint16_t instruction);
+
+private:
+    uint32_t expandQuadrant0(uint16_t instruction);
+    uint32_t expandQuadrant1(uint16_t instruction);
+    uint32_t expandQuadrant2(uint16_t instruction);
+
+    // 32-bit instruction encoders
+    uint32_t encodeR(uint32_t funct7, uint32_t rs2, uint32_t rs1,
+                     uint32_t funct3, uint32_t rd, uint32_t opcode);
+    uint32_t encodeI(uint32_t immediate, uint32_t rs1, uint32_t funct3,
+                     uint32_t rd, uint32_t opcode);
+    uint32_t encodeS(uint32_t immediate, uint32_t rs2, uint32_t rs1,
+                     uint32_t funct3, uint32_t opcode = STORE);
+    uint32_t encodeB(uint32_t immediate, uint32_t rs2, uint32_t rs1,
+                     uint32_t funct3);
+    uint32_t encodeJ(uint32_t immediate, uint32_t rd);
+};
+
+#endif // COMPRESSEDDECODER_H
@@ -5,6 +5,8 @@
 #include <string>
 #include <unordered_map>
 
+#include "Architecture.h"
+
 // Privilege Levels
 #define USER_MODE                   0b00
 #define SUPERVISOR_MODE             0b01
@@ -13,8 +15,22 @@
 
 // CSR Machine Mode Addresses
 enum ControlStateRegisters {
+    CSR_FFLAGS = 0x001,
+    CSR_FRM = 0x002,
+    CSR_FCSR = 0x003,
+    CSR_SSTATUS = 0x100,
+    CSR_SIE = 0x104,
+    CSR_STVEC = 0x105,
+    CSR_SSCRATCH = 0x140,
+    CSR_SEPC = 0x141,
+    CSR_SCAUSE = 0x142,
+    CSR_STVAL = 0x143,
+    CSR_SIP = 0x144,
+    CSR_SATP = 0x180,
     CSR_MSTATUS = 0x300,
     CSR_MISA = 0x301,
+    CSR_MEDELEG = 0x302,
+    CSR_MIDELEG = 0x303,
     CSR_MTVEC = 0x305,
     CSR_MIE = 0x304,
     CSR_MIP = 0x344,
@@ -22,6 +38,8 @@ enum ControlStateRegisters {
     CSR_MEPC = 0x341,
     CSR_MSCRATCH = 0x340,
     CSR_MTVAL = 0x343,
+    CSR_PMPCFG0 = 0x3A0,
+    CSR_PMPADDR0 = 0x3B0,
     CSR_MVENDORID = 0xF11,
     CSR_MARCHID = 0xF12,
     CSR_MIMPID = 0xF13,
@@ -35,17 +53,67 @@ enum ControlStateRegisters {
 #define MTIMECMP_L                  (CSR_BASE + 12)
 #define KEYBOARD                    (CSR_BASE + 16)
 
+#define MSTATUS_SIE_MASK            1
 #define MSTATUS_MIE_MASK            3
+#define MSTATUS_SPIE_MASK           5
 #define MSTATUS_MPIE_MASK           7
+#define MSTATUS_SPP_MASK            8
 #define MSTATUS_MPP_MASK            11
+#define MSTATUS_MPRV_MASK           17
+#define MSTATUS_SUM_MASK            18
+#define MSTATUS_MXR_MASK            19
+
+// sstatus is the view of these mstatus fields
+#define SSTATUS_MASK                ((1 << MSTATUS_SIE_MASK) |             \
+                                     (1 << MSTATUS_SPIE_MASK) |            \
+                                     (1 << MSTATUS_SPP_MASK) |             \
+                                     (1 << MSTATUS_SUM_MASK) |             \
+                                     (1 << MSTATUS_MXR_MASK))
+
+// Supervisor interrupts that can be delegated through mideleg
+#define MIDELEG_MASK                ((1 << MIP_SEIP_MASK) |                \
+                                     (1 << MIP_STIP_MASK) |                \
+                                     (1 << MIP_SSIP_MASK))
+
+// Environment calls from M-mode are never delegated
+#define MEDELEG_MASK                (0xffff & ~(1 << ECALL_FROM_M_MODE))
+
+// satp fields (Sv32)
+#define SATP_MODE_MASK              31
+#define SATP_ASID_MASK              22
+#define SATP_ASID_BITS              0x1ff
+#define SATP_PPN_BITS               0x3fffff
 
 #define MIE_MEIE_MASK               11
 #define MIE_MTIE_MASK               7
 #define MIE_MSIE_MASK               3
 
+// fcsr fields, fflags and frm are views of fcsr
+#define FCSR_FFLAGS_MASK            0x1f
+#define FCSR_FRM_MASK               5
+#define FCSR_MASK                   0xff
+
+// Physical memory protection, pmpcfg0-3 each hold 4 entry configurations
+#define PMP_ENTRIES                 16
+#define PMP_CFG_REGISTERS           (PMP_ENTRIES / 4)
+#define PMP_R                       (1 << 0)
+#define PMP_W                       (1 << 1)
+#define PMP_X                       (1 << 2)
+#define PMP_A_MASK                  3
+#define PMP_L                       (1 << 7)
+
+// Address matching modes of the pmpcfg A field
+#define PMP_A_OFF                   0
+#define PMP_A_TOR                   1
+#define PMP_A_NA4                   2
+#define PMP_A_NAPOT                 3
+
 #define MIP_MEIP_MASK               11
+#define MIP_SEIP_MASK               9
 #define MIP_MTIP_MASK               7
+#define MIP_STIP_MASK               5
 #define MIP_MSIP_MASK               3
+#define MIP_SSIP_MASK               1
 
 class Csr {
 public:
@@ -78,14 +146,49 @@ public:
     uint32_t getMtip(void);
     uint32_t getMsip(void);
 
+    // Supervisor fields of mstatus
+    void setSie(void);
+    void setSpie(void);
+    void setSpp(int mask);
+    void resetSie(void);
+    void resetSpie(void);
+    void resetSpp(void);
+    void resetMprv(void);
+    uint32_t getSie(void);
+    uint32_t getSpie(void);
+    uint32_t getSpp(void);
+
+    // Current privilege level of the hart, not visible as a CSR
+    uint32_t getPrivilegeLevel(void);
+    void setPrivilegeLevel(uint32_t privilegeLevel);
+
+    // Raw contents of every CSR, used for snapshots
+    std::unordered_map<uint32_t, uint32_t> &getRegisters(void);
+
+    // CSR instructions may only access CSRs of their privilege level or
+    // below, and may not write read-only CSRs (address bits 11:10 = 0b11)
+    bool isAccessible(uint32_t address, bool isWrite);
+
     // CSR Standard operations
     void setMepc(uint32_t mepc);
     void setMcause(uint32_t mcause);
     uint32_t getMepc(void);
     uint32_t getMtvec(void);
 
+    // Configuration byte of a PMP entry
+    uint32_t getPmpcfg(uint32_t entry);
+    bool isPmpCsr(uint32_t address);
+
+    // Floating point rounding mode and accrued exception flags
+    uint32_t getFrm(void);
+    void accrueFflags(uint32_t fflags);
+
 private:
+    // pmpcfg/pmpaddr writes are ignored for locked entries
+    void writePmp(uint32_t address, uint32_t data);
+
     std::unordered_map<uint32_t, uint32_t> registers;
+    uint32_t privilegeLevel;
 };
 
 #endif // CSR_H
\ No newline at end of file
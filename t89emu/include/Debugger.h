@@ -0,0 +1,79 @@
+#ifndef DEBUGGER_H
+#define DEBUGGER_H
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <sys/stat.h>
+
+#include "Dwarf/DwarfParser.h"
+#include "InputLog.h"
+#include "Machine.h"
+#include "Mcu.h"
+
+// Debug interface between a machine and gui/dwarf/elf parser. Each debugger
+// owns its machine and debug information, so several can be open at once
+class Debugger {
+public:
+    Debugger(const char *elfPath);
+    ~Debugger();
+
+    void executeInstructions(uint cycles);
+    void stepInstruction(void);
+    void stepLine(void);
+    void addBreakpoint(uint32_t address);
+    void removeBreakpoint(uint32_t address);
+
+    bool isBreakpoint(uint32_t address);
+
+    // Take the state reset() returns to, once the disk image is attached
+    void markLoaded(void);
+
+    // Restart the firmware from its loaded state. Ends recording or replay
+    // of the input log, which covers a single run
+    void reset(void);
+
+    // Reset, loading the firmware again first if its file changed since it
+    // was loaded. Returns false if the new file cannot be loaded, the
+    // machine then keeps running the previous firmware
+    bool reload(void);
+
+    ClintMemoryDevice *getClintDevice(void);
+    RamMemoryDevice *getRamDevice(void);
+    RomMemoryDevice *getRomDevice(void);
+    VideoMemoryDevice *getVideoDevice(void);
+    VirtioBlockMemoryDevice *getVirtioBlockDevice(void);
+    KeyboardMemoryDevice *getKeyboardDevice(void);
+    RegisterFile *getRegisterFileModule(void);
+    ProgramCounter *getProgramCounterModule(void);
+    Csr *getCsrModule(void);
+    ImmediateGenerator *getImmediateGeneratorModule(void);
+    Machine *getMachine(void);
+
+    // Host input of the machine, GUI key events go through it so they can
+    // be recorded and replayed
+    InputLog *getInputLog(void);
+
+    std::vector<DisassembledEntry> &getDisassembledCode(void);
+    void getLocalVariables(std::vector<Variable *> &variables);
+    void getGlobalVariables(std::vector<Variable *> &variables);
+    std::vector<SourceInfo *> &getSourceInfo(void);
+    uint getLineNumberAtPc(void);
+    const std::string &getSourceNameAtPc(void);
+    void getVarInfo(VarInfo &res, bool doUpdate, Variable *var);
+
+private:
+    Machine *machine;
+    Mcu *mcu; // Boot hart of machine
+    InputLog *inputLog;
+
+    // Debugging information, also the firmware image of machine
+    DwarfParser *dwarfParser;
+    std::string elfPath;
+    struct stat elfStat; // File as it was when loaded
+    uint latestSourceLine;
+    std::vector<uint32_t> breakpoints;
+};
+
+#endif // DEBUGGER_H
\ No newline at end of file
@@ -36,7 +36,11 @@ public:
     size_t getNumCompileUnits(void);
     std::vector<SourceInfo *> &getSourceInfo(void);
     uint getLineNumberAtPc(uint32_t pc);
-    std::string &getSourceNameAtPc(uint32_t pc);
+    const std::string &getSourceNameAtPc(uint32_t pc);
+
+    // Line coverage of every compile unit, see LineNumberInfo
+    void getLineCoverage(LineCoverage &coverage,
+        std::function<bool(uint32_t start, uint32_t end)> isExecuted);
     void getLocalVariables(std::vector<Variable *> &variables, uint32_t pc,
                            uint line);
     void getGlobalVariables(std::vector<Variable *> &variables, uint32_t pc,
@@ -1,9 +1,15 @@
 #pragma once
 
+#include <functional>
 #include <map>
+#include <string>
 #include <utility>
 #include <vector>
 
+// Lines of each source path, and whether any of their code executed.
+// Declared ahead of the includes, which lead back to this header
+typedef std::map<std::string, std::map<uint, bool>> LineCoverage;
+
 #include "Dwarf/CompileUnit.h"
 #include <Dwarf/DebugInfoEntry.h>
 #include "Dwarf/DwarfEncodings.h"
@@ -42,7 +48,12 @@ public:
     size_t getLength(void);
     std::vector<SourceInfo *> &getSourceInfo(void);
     uint getLineNumberAtPc(uint32_t pc);
-    std::string &getSourceNameAtPc(uint32_t pc);
+    const std::string &getSourceNameAtPc(uint32_t pc);
+
+    // Add the lines of this unit to coverage. isExecuted tells whether any
+    // instruction in [start, end) executed
+    void getLineCoverage(LineCoverage &coverage,
+        std::function<bool(uint32_t start, uint32_t end)> isExecuted);
 
     static bool containsPath(std::vector<SourceInfo *> &sources,
                              std::string &path);
@@ -75,10 +86,11 @@ private:
 
     struct LineEntry {
         LineEntry(uint32_t address, uint line, uint column, uint file,
-                  bool isStmt, bool prologueEnd, bool epilogueBegin)
+                  bool isStmt, bool prologueEnd, bool epilogueBegin,
+                  bool endSequence)
             : address(address), line(line), column(column), file(file),
               isStmt(isStmt), prolgueEnd(prologueEnd),
-              epilogueBegin(epilogueBegin) {}
+              epilogueBegin(epilogueBegin), endSequence(endSequence) {}
         uint32_t address;
         uint line;
         uint column;
@@ -86,6 +98,7 @@ private:
         bool isStmt; // flags for setting breakpoints
         bool prolgueEnd;
         bool epilogueBegin;
+        bool endSequence; // First address after a sequence, has no code
     };
 
     void clearRegisters(void); // End of every sequence
@@ -10,6 +10,8 @@
 #include <vector>
 
 #include "Architecture.h"
+#include "CompressedDecoder.h"
+#include "FloatingPointUnit.h"
 #include "ImmediateGenerator.h"
 #include "RomMemoryDevice.h"
 
@@ -122,17 +124,30 @@ class ElfParser {
 public:
     ElfParser(const char *path);
     ~ElfParser();
+
+    // Parse a firmware image, returns nullptr instead of exiting if the file
+    // is not an RV32 executable with one ROM and one RAM segment that lie
+    // within the file and fit in the ROM device together
+    static ElfParser *open(const char *path);
     
     void flashRom(RomMemoryDevice *romDevice);
     
+    // Disassembled on the first call, which writes the parser, so it must
+    // not race with other users of a shared parser
     std::vector<struct DisassembledEntry> &getDisassembledCode(void);
     Elf32_Addr getEntryPc(void);
     uint32_t getRamStart(void);
     uint32_t getRomStart(void);
 
+    // Look up a symbol in the symbol table, returns false if it is missing
+    bool getSymbolAddress(const char *name, uint32_t *address);
+
     bool isDebuggable(void);
     
 protected:
+    // Parser that has not read a file yet
+    ElfParser(void);
+
     // Initialize ELF Parsing
     bool initStructures(const char *path);
     bool generateDisassembledCode(void);
@@ -141,6 +156,9 @@ protected:
     const ElfProgramHeader *getProgramHeader(int nentry);
     std::pair<Elf32_Addr, std::string> *getSymbolAtAddress(Elf32_Addr addr);
     std::string generateInstructionStr(struct DisassembledEntry &entry);
+    std::string getBitManipName(uint32_t instruction);
+    std::string getAmoName(uint32_t funct5);
+    std::string getFloatName(uint32_t instruction);
     std::string getCsrName(int csrAddr);
 
     // ELF Header Information
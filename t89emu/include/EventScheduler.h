@@ -0,0 +1,44 @@
+#include <stdint.h>
+#include <functional>
+#include <queue>
+#include <vector>
+
+#ifndef EVENTSCHEDULER_H
+#define EVENTSCHEDULER_H
+
+// Runs device callbacks at a future cycle count. Checking for due events is
+// a single compare per cycle, so devices no longer need to poll each cycle
+class EventScheduler {
+public:
+    EventScheduler(void);
+    ~EventScheduler();
+
+    void schedule(uint64_t cycle, std::function<void(void)> callback);
+
+    // Advance by one cycle, returns true if any events are due
+    inline bool nextCycle(void) { return ++cycle >= nextEventCycle; }
+    void runEvents(void);
+
+    uint64_t getCycle(void);
+
+private:
+    struct Event {
+        uint64_t cycle;
+        uint64_t sequence; // Events at the same cycle run in schedule order
+        std::function<void(void)> callback;
+    };
+
+    struct EventCompare {
+        bool operator()(const Event &a, const Event &b) {
+            return (a.cycle != b.cycle) ? (a.cycle > b.cycle)
+                                        : (a.sequence > b.sequence);
+        }
+    };
+
+    std::priority_queue<Event, std::vector<Event>, EventCompare> events;
+    uint64_t cycle;
+    uint64_t nextEventCycle;
+    uint64_t sequence;
+};
+
+#endif // EVENTSCHEDULER_H
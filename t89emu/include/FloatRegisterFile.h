@@ -0,0 +1,25 @@
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#ifndef FLOATREGISTERFILE_H
+#define FLOATREGISTERFILE_H
+
+// RV32F registers f0-f31. Registers hold raw single precision bits, FLEN is
+// 32 so values never need NaN-boxing
+class FloatRegisterFile {
+public:
+    FloatRegisterFile(void);
+    ~FloatRegisterFile();
+
+    uint32_t read(int reg);
+    void write(uint32_t data, int reg);
+
+    std::vector<std::string>& getNames(void);
+
+private:
+    uint32_t *registers;
+    std::vector<std::string> names;
+};
+
+#endif // FLOATREGISTERFILE_H
@@ -0,0 +1,69 @@
+#include <stdint.h>
+
+#include "Architecture.h"
+
+#ifndef FLOATINGPOINTUNIT_H
+#define FLOATINGPOINTUNIT_H
+
+// Rounding modes (instruction rm field and frm)
+#define RM_RNE                      0b000 // Nearest, ties to even
+#define RM_RTZ                      0b001 // Towards zero
+#define RM_RDN                      0b010 // Down
+#define RM_RUP                      0b011 // Up
+#define RM_RMM                      0b100 // Nearest, ties to max magnitude
+#define RM_DYN                      0b111 // Use frm
+
+// Accrued exception flags (fflags)
+#define FFLAG_NX                    0x01 // Inexact
+#define FFLAG_UF                    0x02 // Underflow
+#define FFLAG_OF                    0x04 // Overflow
+#define FFLAG_DZ                    0x08 // Divide by zero
+#define FFLAG_NV                    0x10 // Invalid operation
+
+#define CANONICAL_NAN               0x7fc00000
+
+// Single precision arithmetic on the host FPU. Host rounding mode is
+// switched to the instruction's rounding mode for each operation, and host
+// exception flags are translated to fflags
+class FloatingPointUnit {
+public:
+    FloatingPointUnit(void);
+    ~FloatingPointUnit();
+
+    // Execute an OP-FP or fused multiply-add instruction. A, B and C are the
+    // raw rs1, rs2 and rs3 values. Returns STATUS_OK or ILLEGAL_INSTRUCTION,
+    // result holds the value for rd and fflags the raised exceptions
+    uint32_t execute(uint32_t instruction, uint32_t A, uint32_t B, uint32_t C,
+                     uint32_t frm, uint32_t *result, uint32_t *fflags);
+
+    // fcvt.s.w[u] and fmv.w.x read rs1 from the integer registers
+    static bool isIntegerSource(uint32_t instruction);
+
+    // Conversions to integer, moves to integer, compares and fclass write
+    // rd in the integer registers
+    static bool isIntegerDestination(uint32_t instruction);
+
+private:
+    uint32_t executeOpFp(uint32_t funct7, uint32_t funct3, uint32_t rs2,
+                         float a, float b, uint32_t A, uint32_t B,
+                         uint32_t rm, uint32_t *result, uint32_t *fflags);
+    uint32_t convertToInteger(float a, uint32_t rm, bool isUnsigned,
+                              uint32_t *fflags);
+    uint32_t minMax(uint32_t A, uint32_t B, bool isMax, uint32_t *fflags);
+    uint32_t compare(uint32_t A, uint32_t B, uint32_t funct3,
+                     uint32_t *fflags);
+    uint32_t classify(uint32_t A);
+
+    void setHostRounding(uint32_t rm);
+    uint32_t getHostFlags(void);
+
+    static inline float toFloat(uint32_t bits);
+    static inline uint32_t toBits(float value);
+    static inline bool isNan(uint32_t bits);
+    static inline bool isSignalingNan(uint32_t bits);
+
+    // Canonical NaN replaces any NaN an arithmetic operation produces
+    static inline uint32_t canonicalize(float value);
+};
+
+#endif // FLOATINGPOINTUNIT_H
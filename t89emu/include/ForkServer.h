@@ -0,0 +1,76 @@
+#include <stdint.h>
+
+#ifndef FORKSERVER_H
+#define FORKSERVER_H
+
+#include "Machine.h"
+#include "Runner.h"
+
+// File descriptors of the AFL fork server protocol, the fuzzer writes
+// requests to the control descriptor and reads replies from the status
+// descriptor
+#define FORKSRV_CONTROL_FD          198
+#define FORKSRV_STATUS_FD           (FORKSRV_CONTROL_FD + 1)
+
+// Exit status of executions that reach the instruction or time limit
+#define FORKSRV_LIMIT_STATUS        124
+
+// Environment variables of the fuzzer, the shared memory id of the coverage
+// bitmap and its size if it is not FORKSRV_MAP_SIZE
+#define FORKSRV_SHM_ENV             "__AFL_SHM_ID"
+#define FORKSRV_MAP_SIZE_ENV        "AFL_MAP_SIZE"
+#define FORKSRV_MAP_SIZE            65536
+
+struct ForkServerOptions {
+    uint32_t startPc = 0;           // Boot until hart 0 reaches this PC
+    uint32_t inputAddress = 0;      // Guest buffer test inputs are copied to
+    uint32_t inputSize = 4096;      // Capacity of the buffer
+    const char *inputPath = nullptr; // Test input file, stdin if nullptr
+    RunOptions run;                 // Limits of each execution
+};
+
+// AFL style fork server. The machine boots once to a start point, usually
+// the entry of a function fuzz_target(const uint8_t *data, size_t size).
+// For each request of the fuzzer the process forks, and the child copies
+// the test input into the guest buffer, passes the buffer and the input
+// size in a0 and a1, and runs. Copy-on-write makes each child start from
+// the warm state without repeating the boot.
+//
+// A child exits with the guest's exit code when firmware exits through
+// semihosting, with 0 when the start function returns, and with
+// FORKSRV_LIMIT_STATUS when it reaches a limit. Misaligned accesses,
+// access faults, illegal instructions and breakpoint exceptions are
+// crashes: the child aborts so the fuzzer records the input
+class ForkServer {
+public:
+    ForkServer(Machine *machine, const ForkServerOptions &options);
+
+    // Run until hart 0 reaches the start PC, returns false if firmware
+    // exits or crashes first, or maxInstructions pass (0 is unlimited)
+    bool boot(uint64_t maxInstructions);
+
+    // Serve fuzzer requests until the control pipe closes. Without a
+    // fuzzer attached, runs the input once in this process instead.
+    // Returns the exit status of the process
+    int serve(void);
+
+private:
+    // Copy the test input into the guest and run it to completion. Returns
+    // the exit status, or aborts on a crash
+    int execute(void);
+
+    // Attach the fuzzer's coverage bitmap to every hart, if there is one
+    void attachCoverageMap(void);
+
+    // Exceptions that count as crashes
+    static bool isCrash(uint32_t exceptionCode);
+
+    Machine *machine;
+    ForkServerOptions options;
+
+    // Hart 0 reaching the return address of the start function ends an
+    // execution
+    uint32_t returnAddress;
+};
+
+#endif // FORKSERVER_H
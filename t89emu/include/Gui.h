@@ -18,13 +18,13 @@
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
-#include "McuDebug.h"
+#include "Debugger.h"
 
 #define INSTRUCTIONS_PER_FRAME 1000000
 
 class Gui {
 public:
-    Gui(McuDebug *debug);
+    Gui(Debugger *debug);
     ~Gui();
     void runApplication(void);
 
@@ -49,7 +49,7 @@ private:
 
     std::string getInstructionStr(struct DisassembledEntry &entry);
 
-    McuDebug *debug;
+    Debugger *debug;
 
     // GLFW Window context
     GLFWwindow *window;
@@ -68,9 +68,10 @@ private:
     float textureW;
     float textureH;
     GLuint textureID;
+    std::vector<std::pair<uint32_t, uint32_t>> dirtySpans;
 
-    // I/O Panel
-    std::vector<ImGuiKey> buttons;
+    // I/O Panel, host keys and the scancodes sent to the keyboard device
+    std::vector<std::pair<ImGuiKey, uint16_t>> keyScancodes;
     
     // General Purpose Registers
     std::vector<std::pair<std::string, uint32_t>> registers;
@@ -83,7 +84,12 @@ private:
     // uint goldSourceLine;
 
     bool isRunEnabled;
+    bool isReloadFailed;
     // std::vector<uint32_t> breakpoints;
+
+    // Addresses typed into the disassembly and memory viewer panels
+    char breakpointHexBuf[9];
+    char jumpHexBuf[9];
     
     ImFont *vramFont;
 };
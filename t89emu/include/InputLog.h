@@ -0,0 +1,92 @@
+#include <stdint.h>
+#include <cstdio>
+
+#ifndef INPUTLOG_H
+#define INPUTLOG_H
+
+#include "Mcu.h"
+
+// Log header, the magic is followed by a version byte
+#define INPUTLOG_MAGIC              "T89L"
+#define INPUTLOG_VERSION            1
+
+// Record types
+#define INPUTLOG_KEY                1 // Scancode, bit 16 set on release
+#define INPUTLOG_TIME               2 // Host time, delta from the last one
+
+// Records the inputs of a machine that come from the host, and replays
+// them. Guest time is the boot hart's cycle count, so everything else the
+// firmware sees is already a function of the firmware, scripted inputs and
+// disk image. A replay is exact for a single hart, or harts interleaved on
+// one thread.
+//
+// The log is a stream of records in cycle order, each a varint cycle delta
+// from the previous record, a type byte and a varint payload. Records are
+// written through a buffered file as they happen and read back one at a
+// time, so logs of any length can be recorded and replayed. Key events and
+// host time reads take a few bytes each
+class InputLog {
+public:
+    InputLog(Mcu *bootHart);
+    ~InputLog();
+
+    // Start recording to or replaying from a log, returns false if the file
+    // cannot be opened or is not a log. Call before the machine runs
+    bool record(const char *path);
+    bool replay(const char *path);
+
+    inline bool isRecording(void) {return mode == MODE_RECORD;}
+    inline bool isReplaying(void) {return mode == MODE_REPLAY;}
+
+    // True once the firmware reads host time the log does not have, or
+    // passes a logged read without making it. The replay no longer matches
+    // the recording from then on
+    bool hasDiverged(void);
+
+    // Key event from the host. While recording it reaches the keyboard at
+    // the start of the next cycle so it can be replayed at the same point,
+    // while replaying it is dropped in favor of the logged events
+    void injectKey(uint16_t scancode, bool isRelease);
+
+    // Host time in ns read by the semihosting device, replaced with the
+    // logged time while replaying
+    uint64_t readTime(uint64_t hostTime);
+
+private:
+    enum Mode {MODE_OFF, MODE_RECORD, MODE_REPLAY};
+
+    void writeRecord(uint8_t type, uint64_t payload);
+
+    // Read the record after the current one into next, schedules it if it
+    // is a key event. Returns false at the end of the log
+    bool readRecord(void);
+
+    void writeVarint(uint64_t value);
+    bool readVarint(uint64_t *value);
+
+    // Report the first divergence of a replay
+    void diverge(const char *reason);
+
+    Mode mode;
+    FILE *file;
+    bool isDiverged;
+
+    // Cycle of the last record, and the last host time
+    uint64_t lastCycle;
+    uint64_t lastTime;
+
+    // Record read ahead of the replay, valid if hasNext
+    struct Record {
+        uint64_t cycle;
+        uint8_t type;
+        uint64_t payload;
+    };
+    Record next;
+    bool hasNext;
+
+    EventScheduler *scheduler;
+    KeyboardMemoryDevice *keyboard;
+    SemihostMemoryDevice *semihost;
+};
+
+#endif // INPUTLOG_H
@@ -0,0 +1,72 @@
+#include <stdint.h>
+#include <deque>
+
+#include "Architecture.h"
+#include "EventScheduler.h"
+#include "MemoryDevice.h"
+#include "PlicMemoryDevice.h"
+
+#ifndef KEYBOARDMEMORYDEVICE_H
+#define KEYBOARDMEMORYDEVICE_H
+
+// Size and offsets do not change across Keyboard devices
+#define KEYBOARD_SIZE               0x10
+
+#define KEYBOARD_STATUS_OFFSET      0x0 // Read only
+#define KEYBOARD_EVENT_OFFSET       0x4 // Read pops the oldest event
+#define KEYBOARD_TIMESTAMP_OFFSET   0x8 // Read only, cycle of popped event
+#define KEYBOARD_CONTROL_OFFSET     0xc
+
+#define KEYBOARD_FIFO_DEPTH         64
+
+// Status register
+#define KEYBOARD_STATUS_COUNT       0xffff // Events waiting in the FIFO
+#define KEYBOARD_STATUS_OVERFLOW    0x80000000 // Events were dropped
+
+// Event register
+#define KEYBOARD_EVENT_SCANCODE     0xffff
+#define KEYBOARD_EVENT_RELEASE      0x10000
+#define KEYBOARD_EVENT_VALID        0x80000000
+
+// Control register
+#define KEYBOARD_CONTROL_FLUSH      0x1 // Empty FIFO, clear overflow
+
+class KeyboardMemoryDevice : public MemoryDevice {
+public:
+    KeyboardMemoryDevice(uint32_t base, uint32_t size,
+                         EventScheduler *scheduler, PlicMemoryDevice *plic,
+                         uint32_t irq);
+
+    uint32_t read(uint32_t addr, uint32_t size, uint32_t *readValue);
+    uint32_t write(uint32_t addr, uint32_t value, uint32_t size);
+
+    // Queue a key event timestamped with the current cycle
+    void pushEvent(uint16_t scancode, bool isRelease);
+
+    // Schedule events from a script, one "<cycle> press|release <scancode>"
+    // per line, '#' starts a comment
+    bool loadScript(const char *path);
+
+    // Queued events are part of the state
+    void saveState(std::vector<uint8_t> &state);
+    void restoreState(const std::vector<uint8_t> &state);
+
+private:
+    struct KeyEvent {
+        uint64_t cycle;
+        uint16_t scancode;
+        bool isRelease;
+    };
+
+    void popEvent(void);
+    void updateStatus(void);
+
+    std::deque<KeyEvent> fifo;
+    bool isOverflow;
+
+    EventScheduler *scheduler;
+    PlicMemoryDevice *plic;
+    uint32_t irq;
+};
+
+#endif // KEYBOARDMEMORYDEVICE_H
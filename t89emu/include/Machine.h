@@ -0,0 +1,73 @@
+#include <stdint.h>
+#include <vector>
+
+#ifndef MACHINE_H
+#define MACHINE_H
+
+#include "ElfParser.h"
+#include "Mcu.h"
+#include "Smp.h"
+
+// A complete emulated machine: harts, memory and devices, flashed with a
+// firmware image. Machines share no mutable state, so any number of them
+// can live in one process and run on different threads. A parsed ELF is
+// only read by the machine, so machines running the same firmware can share
+// one parser instead of parsing the file again
+class Machine {
+public:
+    // Parse the firmware at elfPath, the machine owns the parser
+    Machine(const char *elfPath, uint32_t numHarts);
+
+    // Use an already parsed firmware image, which must outlive the machine
+    Machine(ElfParser *elfParser, uint32_t numHarts);
+    ~Machine();
+
+    Smp *getSmp(void);
+    uint32_t getNumHarts(void);
+
+    // Boot hart, owner of the memory and devices
+    Mcu *getMcu(void);
+
+    ElfParser *getElfParser(void);
+
+    // Complete state of the machine: harts, devices and scheduled events. A
+    // snapshot can only be restored into the machine it was taken from, and
+    // only while no harts are running. ROM is not saved since firmware
+    // cannot write it, and neither are the contents of a disk image
+    struct Snapshot {
+        std::vector<Mcu::HartState> harts;
+        std::vector<std::vector<uint8_t>> devices;
+        EventScheduler scheduler;
+    };
+    void saveSnapshot(Snapshot &snapshot);
+    void restoreSnapshot(const Snapshot &snapshot);
+
+    // Take the state reset() returns to. The machine takes it once the
+    // firmware is flashed, callers that attach a disk image or load a
+    // keyboard script call this afterwards so reset() keeps them
+    void markLoaded(void);
+
+    // Return registers, CSRs, devices, RAM and scheduled events to their
+    // state at the last markLoaded(). Harts, devices and their pointers
+    // stay the same. An attached disk image stays attached, but sectors the
+    // firmware wrote to it are not restored
+    void reset(void);
+
+    // Flash another firmware image into the machine and reset it to the new
+    // image's entry point. The image must outlive the machine, and the
+    // machine no longer uses its previous image. Returns false if the image
+    // places ROM or RAM elsewhere, which needs a new machine
+    bool load(ElfParser *elfParser);
+
+private:
+    void init(uint32_t numHarts);
+
+    ElfParser *elfParser;
+    bool isElfParserOwned;
+    Smp *smp;
+
+    // State reset() returns to
+    Snapshot loadedState;
+};
+
+#endif // MACHINE_H
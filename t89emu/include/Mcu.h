@@ -1,35 +1,99 @@
 #include <stdint.h>
+#include <algorithm>
 #include <map>
 #include <iostream>
 #include <fstream>
+#include <unordered_map>
+#include <vector>
 
 #ifndef MCU_H
 #define MCU_H
 
 #include "Alu.h"
 #include "AluControlUnit.h"
+#include "BlitterMemoryDevice.h"
 #include "Bus.h"
+#include "CompressedDecoder.h"
 #include "Csr.h"
+#include "EventScheduler.h"
+#include "FloatRegisterFile.h"
+#include "FloatingPointUnit.h"
 #include "ImmediateGenerator.h"
+#include "KeyboardMemoryDevice.h"
 #include "MemControlUnit.h"
+#include "Mmu.h"
 #include "NextPc.h"
+#include "PlicMemoryDevice.h"
 #include "ProgramCounter.h"
 #include "RegisterFile.h"
+#include "SemihostMemoryDevice.h"
 #include "Trap.h"
+#include "VirtioBlockMemoryDevice.h"
 
 class Mcu {
 public:
     Mcu(uint32_t romBase, uint32_t ramBase, uint32_t entryPc);
+
+    // Additional hart sharing the bus, memory and devices of bootHart
+    Mcu(Mcu *bootHart, uint32_t hartId, uint32_t entryPc);
     ~Mcu();
 
     void nextInstruction(void);
 
+    // True while the hart waits in WFI and no interrupt is pending and
+    // enabled in mie. nextInstruction() only advances the cycle then
+    bool isIdle(void);
+
+    // Drop predecoded instructions, call after the ROM contents change or
+    // after writing RAM through getBuffer()
+    void invalidatePredecodeCache(void);
+
+    // Architectural state of a hart, saved and restored by snapshots
+    struct HartState {
+        uint32_t pc;
+        uint32_t registers[32];
+        uint32_t floatRegisters[32];
+        std::unordered_map<uint32_t, uint32_t> csrs;
+        uint32_t privilegeLevel;
+        bool isReserved;
+        uint32_t reservationAddr;
+        uint32_t reservationValue;
+        bool isWaiting;
+    };
+    void saveState(HartState &state);
+    void restoreState(const HartState &state);
+
+    uint32_t getHartId(void);
+
+    // Count control flow edges into map, an AFL style bitmap of size bytes
+    // (a power of two). Edges are recorded when the hart enters a new basic
+    // block: after jumps, branches, traps and trap returns. nullptr turns
+    // coverage off. Harts on different threads may lose counts when they
+    // share a map
+    void setCoverageMap(uint8_t *map, uint32_t size);
+
+    // Start the next execution without an edge from the previous one
+    inline void resetCoverageLocation(void) {coveragePrevLocation = 0;}
+
+    // Mark executed ROM instructions in map, one byte per ROM halfword set
+    // to 1 at the offset of each instruction. nullptr turns it off
+    void setExecutionMap(uint8_t *map);
+
+    // Exceptions taken by the hart and the cause of the last one, lets
+    // runners notice faults without a hook on the trap path
+    inline uint64_t getExceptionCount(void) {return exceptionCount;}
+    inline uint32_t getLastException(void) {return lastException;}
+
     Alu *getAluModule(void);
     AluControlUnit *getAluControlUnitModule(void);
     Bus *getBusModule(void);
     Csr *getCsrModule(void);
+    EventScheduler *getEventSchedulerModule(void);
+    FloatRegisterFile *getFloatRegisterFileModule(void);
+    FloatingPointUnit *getFloatingPointUnitModule(void);
     ImmediateGenerator *getImmediateGeneratorModule(void);
     MemControlUnit *getMemControlUnitModule(void);
+    Mmu *getMmuModule(void);
     NextPc *getNextPcModule(void);
     ProgramCounter *getProgramCounterModule(void);
     RegisterFile *getRegisterFileModule(void);
@@ -41,15 +105,49 @@ public:
     RamMemoryDevice *getRamDevice(void) {return ram;}
     VideoMemoryDevice *getVideoDevice(void) {return vram;}
     ClintMemoryDevice *getClintDevice(void) {return clint;}
+    PlicMemoryDevice *getPlicDevice(void) {return plic;}
+    VirtioBlockMemoryDevice *getVirtioBlockDevice(void) {return virtioBlock;}
+    BlitterMemoryDevice *getBlitterDevice(void) {return blitter;}
+    KeyboardMemoryDevice *getKeyboardDevice(void) {return keyboard;}
+    SemihostMemoryDevice *getSemihostDevice(void) {return semihost;}
 #endif // BUS_EXPERIMENTAL
 
 private:
+    // Create the core state owned by each hart
+    void initHart(uint32_t hartId, uint32_t romBase, uint32_t entryPc);
+
     // Execute a normal RV32I instruction
     // If the instruction is executed successfully, function returns true
     // Otherwise, function returns false and stores the type of exception
     // which will then invoke the CPU to take_trap()
     uint32_t executeInstruction(void);
 
+    // Fetch the instruction at pcAddr, compressed instructions are returned
+    // already expanded along with their original length in bytes. paddr is
+    // the physical address pcAddr translates to
+    uint32_t fetchInstruction(uint32_t pcAddr, uint32_t *instruction,
+                              uint32_t *length, uint32_t *paddr);
+
+    // Execute an RV32A instruction, returns STATUS_OK or an exception code
+    uint32_t executeAtomic(uint32_t funct5, uint32_t vaddr, uint32_t rs2Data,
+                           uint32_t rd);
+
+    // Translate and access data memory. On failure the virtual address is
+    // kept as the trap value
+    uint32_t loadData(uint32_t vaddr, uint32_t size, uint32_t *readValue);
+    uint32_t storeData(uint32_t vaddr, uint32_t value, uint32_t size);
+
+    // Execute MRET/SRET/SFENCE.VMA/WFI/ECALL, returns STATUS_OK or an
+    // exception code. returnPc is set for MRET and SRET
+    uint32_t executeSystem(uint32_t instruction, uint32_t *returnPc);
+
+    // Execute a CSR instruction, returns STATUS_OK or an exception code
+    uint32_t executeCsr(uint32_t funct3, uint32_t csrAddr, uint32_t rs1,
+                        uint32_t rd);
+
+    // Execute an RV32F instruction, returns STATUS_OK or an exception code
+    uint32_t executeFloat(uint32_t instruction, uint32_t immediate);
+
     void debugPreExecute(uint32_t opcode, uint32_t funct3, uint32_t funct7,
                          uint32_t rs1, uint32_t rs2, uint32_t rd,
                          uint32_t immediate, uint32_t csrAddr,
@@ -62,14 +160,71 @@ private:
     Alu *alu;
     AluControlUnit *aluc;
     Bus *bus;
+    CompressedDecoder *decoder;
     Csr *csr;
+    EventScheduler *scheduler;
+    FloatRegisterFile *frf;
+    FloatingPointUnit *fpu;
     ImmediateGenerator *immgen;
     MemControlUnit *mcu;
+    Mmu *mmu;
     NextPc *nextPc;
     ProgramCounter *pc;
     RegisterFile *rf;
     Trap *trap;
 
+    // mhartid of this hart. The boot hart owns the bus and devices, and is
+    // the only hart that runs scheduled events and takes PLIC interrupts
+    uint32_t hartId;
+    bool isBootHart;
+
+    // ROM and RAM instructions are decoded and expanded once, then reused.
+    // Entries are indexed by halfword offset from the start of the memory, a
+    // length of 0 marks an entry that has not been decoded yet
+    struct PredecodedInstruction {
+        uint32_t instruction;
+        uint32_t length;
+    };
+    std::vector<PredecodedInstruction> predecodeCache;
+    uint32_t predecodeBase;
+
+    // RAM entries of a page are dropped when the page version the RAM keeps
+    // no longer matches the version they were decoded at
+    std::vector<PredecodedInstruction> ramPredecodeCache;
+    std::vector<uint32_t> ramPageVersions;
+
+    // Cache entry for the instruction at paddr, nullptr if it is not cached
+    PredecodedInstruction *getPredecodeEntry(uint32_t paddr);
+
+    // LR/SC reservation. SC compares against the value LR loaded, so a store
+    // from another hart in between makes the SC fail
+    bool isReserved;
+    uint32_t reservationAddr;
+    uint32_t reservationValue;
+
+    // Set by WFI. The hart resumes once an interrupt is pending and enabled
+    // in mie, and takes it if interrupts are globally enabled
+    bool isWaiting;
+
+    // Faulting address of the last memory exception, written to mtval/stval
+    uint32_t trapValue;
+
+    uint64_t exceptionCount;
+    uint32_t lastException;
+
+    // Record the edge from the previous block to the block at targetPc
+    inline void recordEdge(uint32_t targetPc) {
+        uint32_t location = ((targetPc >> 4) ^ (targetPc << 8)) & coverageMask;
+        coverageMap[location ^ coveragePrevLocation]++;
+        coveragePrevLocation = location >> 1;
+    }
+
+    uint8_t *coverageMap;
+    uint32_t coverageMask;
+    uint32_t coveragePrevLocation;
+
+    uint8_t *executionMap;
+
 #ifndef BUS_EXPERIMENTAL
 #else
     // Peripheral modules
@@ -77,6 +232,11 @@ private:
     RamMemoryDevice *ram;
     VideoMemoryDevice *vram;
     ClintMemoryDevice *clint;
+    PlicMemoryDevice *plic;
+    VirtioBlockMemoryDevice *virtioBlock;
+    BlitterMemoryDevice *blitter;
+    KeyboardMemoryDevice *keyboard;
+    SemihostMemoryDevice *semihost;
 #endif // BUS_EXPERIMENTAL
 
 };
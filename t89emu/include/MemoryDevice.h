@@ -1,4 +1,6 @@
 #include <stdint.h>
+#include <string.h>
+#include <vector>
 
 #include "Architecture.h"
 
@@ -23,13 +25,60 @@ public:
     virtual uint32_t write(uint32_t addr, uint32_t write_value,
                            uint32_t size) = 0;
 
+    // Bulk copy between the device buffer and host memory, used by DMA
+    // capable devices. Returns STATUS_OK or an access fault exception code
+    virtual uint32_t readBlock(uint32_t addr, uint8_t *dst, uint32_t size);
+    virtual uint32_t writeBlock(uint32_t addr, const uint8_t *src,
+                                uint32_t size);
+
+    // Word sized atomic memory operations used by the A extension. The
+    // default implementations are built from read/write, devices whose
+    // memory may be shared between host threads override them with host
+    // atomics. atomicOperation returns the previous value in readValue,
+    // compareAndSwap only stores value if the word still holds expected
+    virtual uint32_t atomicOperation(uint32_t addr, uint32_t operation,
+                                     uint32_t operand, uint32_t *readValue);
+    virtual uint32_t compareAndSwap(uint32_t addr, uint32_t expected,
+                                    uint32_t value, bool *isSwapped);
+
+    // Devices that can be accessed from several hart threads at once
+    // without the bus serializing them
+    virtual bool isThreadSafe(void) {return false;}
+
+    // Snapshot support. The default saves the device buffer, devices with
+    // state outside of it append that state after the buffer. A state may
+    // only be restored into the device it was saved from
+    virtual void saveState(std::vector<uint8_t> &state);
+    virtual void restoreState(const std::vector<uint8_t> &state);
+
     inline uint32_t getBaseAddress(void) {return baseAddress;}
     inline uint32_t getEndAddress(void) {return baseAddress + deviceSize;}
+    inline bool containsBlock(uint32_t addr, uint32_t size) {
+        return (addr >= baseAddress) && (addr - baseAddress <= deviceSize) &&
+               (size <= deviceSize - (addr - baseAddress));
+    }
 
     uint32_t getDeviceSize(void);
     uint8_t *getBuffer(void);
 
 protected:
+    // Result of applying an AMO operation to the current memory value
+    static uint32_t calculateAtomic(uint32_t operation, uint32_t current,
+                                    uint32_t operand);
+
+    // Append a plain value to a saved state, or read it back at offset
+    template <typename T>
+    static void appendState(std::vector<uint8_t> &state, const T &value) {
+        const uint8_t *bytes = (const uint8_t *)&value;
+        state.insert(state.end(), bytes, bytes + sizeof(T));
+    }
+    template <typename T>
+    static void loadState(const std::vector<uint8_t> &state, size_t *offset,
+                          T *value) {
+        memcpy(value, &state[*offset], sizeof(T));
+        *offset += sizeof(T);
+    }
+
     uint32_t baseAddress;
     uint32_t deviceSize;
     uint8_t *mem;
@@ -0,0 +1,125 @@
+#include <stdint.h>
+
+#ifndef MMU_H
+#define MMU_H
+
+#include "Architecture.h"
+#include "Bus.h"
+#include "Csr.h"
+#include "Pmp.h"
+
+// Memory access types, each has its own TLB
+#define ACCESS_FETCH                0
+#define ACCESS_LOAD                 1
+#define ACCESS_STORE                2
+#define ACCESS_TYPES                3
+
+// Direct mapped TLB entries per access type, indexed by the low VPN bits
+#define TLB_ENTRIES                 64
+
+#define PAGE_SHIFT                  12
+#define PAGE_SIZE                   (1 << PAGE_SHIFT)
+
+// Sv32 page table entry bits
+#define PTE_V                       (1 << 0)
+#define PTE_R                       (1 << 1)
+#define PTE_W                       (1 << 2)
+#define PTE_X                       (1 << 3)
+#define PTE_U                       (1 << 4)
+#define PTE_G                       (1 << 5)
+#define PTE_A                       (1 << 6)
+#define PTE_D                       (1 << 7)
+
+// Sv32 address translation with an ASID tagged software TLB. Translations
+// are only cached once the accessed (and for stores, dirty) bits are set
+// in the page table, so a TLB hit never has to write the page table. Hits
+// only need a tag compare and a lookup in a permission table that is
+// rebuilt when the privilege level or mstatus change
+class Mmu {
+public:
+    Mmu(Bus *bus);
+    ~Mmu();
+
+    // Reload the translation mode after satp, mstatus or the privilege
+    // level change
+    void update(Csr *csr);
+
+    // Translate a virtual address for an access of size bytes and check the
+    // physical address against PMP. Returns STATUS_OK, a page fault, or an
+    // access fault
+    inline uint32_t translate(uint32_t vaddr, uint32_t size,
+                              uint32_t accessType, uint32_t *paddr) {
+        if (!isTranslated[accessType]) {
+            *paddr = vaddr;
+        } else {
+            uint32_t vpn = vaddr >> PAGE_SHIFT;
+            TlbEntry &entry = tlb[accessType][vpn % TLB_ENTRIES];
+            if (entry.vpn == vpn &&
+                (entry.asid == asid || (entry.flags & PTE_G)) &&
+                isPermitted[accessType][entry.flags]) {
+                hits[accessType]++;
+                *paddr = entry.ppn << PAGE_SHIFT | (vaddr & (PAGE_SIZE - 1));
+            } else {
+                misses[accessType]++;
+                uint32_t exceptionCode = walk(vaddr, accessType, paddr);
+                if (exceptionCode != STATUS_OK) {
+                    return exceptionCode;
+                }
+            }
+        }
+
+        if (!pmp->isAllowed(*paddr, size, accessType,
+                            isMachineAccess[accessType])) {
+            return getAccessFault(accessType);
+        }
+        return STATUS_OK;
+    }
+
+    // SFENCE.VMA, drop cached translations of vaddr and/or asid
+    void flush(uint32_t vaddr, uint32_t asid, bool isAllAddresses,
+               bool isAllAsids);
+
+    // Physical memory protection, update it after pmpcfg/pmpaddr writes
+    Pmp *getPmp(void);
+
+    uint64_t getTlbHits(uint32_t accessType);
+    uint64_t getTlbMisses(uint32_t accessType);
+    void resetTlbCounters(void);
+
+private:
+    struct TlbEntry {
+        uint32_t vpn; // TLB_INVALID_VPN when empty
+        uint32_t ppn;
+        uint32_t asid;
+        uint32_t flags; // PTE bits 7:0
+    };
+
+    // Walk the page table and fill the TLB entry of vaddr
+    uint32_t walk(uint32_t vaddr, uint32_t accessType, uint32_t *paddr);
+
+    // Rebuild isPermitted for an effective privilege level per access type
+    void buildPermissions(uint32_t fetchPrivilege, uint32_t dataPrivilege,
+                          bool isSum, bool isMxr);
+
+    uint32_t getPageFault(uint32_t accessType);
+    uint32_t getAccessFault(uint32_t accessType);
+
+    Bus *bus;
+    Pmp *pmp;
+
+    TlbEntry tlb[ACCESS_TYPES][TLB_ENTRIES];
+    bool isPermitted[ACCESS_TYPES][256];
+    bool isTranslated[ACCESS_TYPES];
+    bool isMachineAccess[ACCESS_TYPES]; // Effective privilege is M
+    uint32_t asid;
+    uint32_t rootPpn;
+
+    // Key of the current permission table, avoids rebuilding it when the
+    // privilege context did not change
+    uint32_t permissionKey;
+
+    uint64_t hits[ACCESS_TYPES];
+    uint64_t misses[ACCESS_TYPES];
+};
+
+#endif // MMU_H
@@ -10,8 +10,10 @@ public:
     NextPc(void);
     ~NextPc();
 
+    // length is the size in bytes of the current instruction (2 or 4)
     uint32_t calculateNextPc(uint32_t offset, uint32_t opcode, uint32_t funct3,
-                             uint32_t A, uint32_t B, uint32_t mepc);
+                             uint32_t A, uint32_t B, uint32_t epc,
+                             uint32_t length);
 
     uint32_t getNextPc(void);
     void setNextPc(uint32_t nextPc);
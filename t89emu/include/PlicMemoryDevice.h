@@ -0,0 +1,39 @@
+#include <stdint.h>
+
+#include "Architecture.h"
+#include "Csr.h"
+#include "MemoryDevice.h"
+
+#ifndef PLICMEMORYDEVICE_H
+#define PLICMEMORYDEVICE_H
+
+// Size and offsets do not change across Plic devices
+#define PLIC_SIZE               0xc
+
+#define PLIC_PENDING_OFFSET     0x0
+#define PLIC_ENABLE_OFFSET      0x4
+
+// Reading claims the highest priority (lowest id) pending source,
+// writing the id back signals completion
+#define PLIC_CLAIM_OFFSET       0x8
+
+// Source 0 is reserved to mean "no interrupt"
+#define PLIC_NUM_SOURCES        32
+
+class PlicMemoryDevice : public MemoryDevice {
+public:
+    PlicMemoryDevice(uint32_t base, uint32_t size);
+    uint32_t read(uint32_t addr, uint32_t size, uint32_t *read_value);
+    uint32_t write(uint32_t addr, uint32_t write_value, uint32_t size);
+
+    // Called by peripherals to signal an external interrupt
+    void raiseInterrupt(uint32_t source);
+
+    // Drive the MEIP line of the hart
+    void nextCycle(Csr *csr);
+
+private:
+    uint32_t claimInterrupt(void);
+};
+
+#endif // PLICMEMORYDEVICE_H
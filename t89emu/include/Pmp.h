@@ -0,0 +1,64 @@
+#include <stdint.h>
+#include <vector>
+
+#ifndef PMP_H
+#define PMP_H
+
+#include "Csr.h"
+
+// Per-page summary bits. The low 3 bits are the accesses S/U-mode may do,
+// the next 3 bits the accesses M-mode may do, indexed by access type
+#define PMP_PAGE_MACHINE_SHIFT      3
+#define PMP_PAGE_PARTIAL            (1 << 7)
+
+#define PMP_PAGES                   (1 << 20)
+
+// Physical memory protection. Instead of matching all 16 entries on every
+// access, the entries are compiled into a permission byte per 4 KiB page
+// when a PMP CSR is written. Pages that are only partly covered by the
+// highest priority entry overlapping them fall back to matching entries
+class Pmp {
+public:
+    Pmp(void);
+    ~Pmp();
+
+    // Recompile the page permissions after a pmpcfg/pmpaddr write
+    void update(Csr *csr);
+
+    // Returns true if an access of size bytes at paddr is permitted
+    inline bool isAllowed(uint32_t paddr, uint32_t size, uint32_t accessType,
+                          bool isMachine) {
+        // Without active entries every access is permitted
+        if (!isEnabled) {
+            return true;
+        }
+
+        uint32_t required = 1 << (accessType +
+                                  (isMachine ? PMP_PAGE_MACHINE_SHIFT : 0));
+        if ((pages[paddr >> 12] & required) &&
+            (paddr & 0xfff) + size <= 0x1000) {
+            return true;
+        }
+        return isAllowedByEntries(paddr, size, accessType, isMachine);
+    }
+
+private:
+    struct Region {
+        uint64_t start;
+        uint64_t end; // Exclusive, start == end for an inactive entry
+        uint32_t cfg;
+    };
+
+    // Match the access against every entry in priority order
+    bool isAllowedByEntries(uint32_t paddr, uint32_t size,
+                            uint32_t accessType, bool isMachine);
+
+    // Page permission bits granted by a matching entry
+    uint8_t getPagePermissions(uint32_t cfg);
+
+    Region regions[PMP_ENTRIES];
+    std::vector<uint8_t> pages;
+    bool isEnabled;
+};
+
+#endif // PMP_H
@@ -1,16 +1,55 @@
 #include <stdint.h>
+#include <vector>
 
 #include "MemoryDevice.h"
 
 #ifndef RAM_MEMORYDEVICE_H
 #define RAM_MEMORYDEVICE_H
 
+// Granularity of self-modifying code detection
+#define CODE_PAGE_SHIFT             12
+#define CODE_PAGE_SIZE              (1 << CODE_PAGE_SHIFT)
+
 class RamMemoryDevice : public MemoryDevice {
 public:
     RamMemoryDevice(uint32_t base, uint32_t size);
     
     uint32_t read(uint32_t addr, uint32_t size, uint32_t *readValue);
     uint32_t write(uint32_t addr, uint32_t writeValue, uint32_t size);
+    uint32_t writeBlock(uint32_t addr, const uint8_t *src, uint32_t size);
+
+    // Restoring counts as a store to every page
+    void restoreState(const std::vector<uint8_t> &state);
+
+    bool isThreadSafe(void) {return true;}
+
+    // RAM may be shared between harts, so AMOs use host atomics
+    uint32_t atomicOperation(uint32_t addr, uint32_t operation,
+                             uint32_t operand, uint32_t *readValue);
+    uint32_t compareAndSwap(uint32_t addr, uint32_t expected, uint32_t value,
+                            bool *isSwapped);
+
+    // Harts call protectPage before decoding instructions from a page. The
+    // next store to the page increments its version, which tells harts to
+    // drop what they decoded from it. Stores to other pages only test a flag
+    inline void protectPage(uint32_t page) {
+        __atomic_store_n(&codePages[page], 1, __ATOMIC_RELAXED);
+    }
+    inline uint32_t getPageVersion(uint32_t page) {
+        return __atomic_load_n(&pageVersions[page], __ATOMIC_ACQUIRE);
+    }
+
+private:
+    inline void checkCodePage(uint32_t addr) {
+        uint32_t page = (addr - baseAddress) >> CODE_PAGE_SHIFT;
+        if (__atomic_load_n(&codePages[page], __ATOMIC_RELAXED)) {
+            __atomic_store_n(&codePages[page], 0, __ATOMIC_RELAXED);
+            __atomic_fetch_add(&pageVersions[page], 1, __ATOMIC_RELEASE);
+        }
+    }
+
+    std::vector<uint8_t> codePages;
+    std::vector<uint32_t> pageVersions;
 };
 
 #endif // RAM_MEMORYDEVICE_H
\ No newline at end of file
@@ -5,12 +5,19 @@
 #ifndef ROM_MEMORYDEVICE_H
 #define ROM_MEMORYDEVICE_H
 
+// Firmware images are flashed into a ROM of this size, ROM then RAM contents
+#define ROM_SIZE                        2097152 // 2 MB
+
 class RomMemoryDevice : public MemoryDevice {
 public:
     RomMemoryDevice(uint32_t base, uint32_t size);
 
     uint32_t read(uint32_t addr, uint32_t size, uint32_t *readValue);
     uint32_t write(uint32_t addr, uint32_t writeValue, uint32_t size);
+    uint32_t writeBlock(uint32_t addr, const uint8_t *src, uint32_t size);
+
+    // Contents only change while flashing, before harts run
+    bool isThreadSafe(void) {return true;}
 };
 
 #endif // ROM_MEMORYDEVICE_H
\ No newline at end of file
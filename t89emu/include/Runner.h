@@ -0,0 +1,62 @@
+#include <stdint.h>
+#include <vector>
+
+#ifndef RUNNER_H
+#define RUNNER_H
+
+#include "Smp.h"
+
+// Instructions executed between wall-clock checks of the single-hart loop
+#define RUNNER_CHECK_INTERVAL       100000
+
+// Polling period of the wall-clock limit when harts run on other threads
+#define RUNNER_POLL_MS              10
+
+// Why a run stopped
+#define RUN_GUEST_EXIT              "guest exit"
+#define RUN_HALT_ADDRESS            "halt address"
+#define RUN_JUMP_TO_SELF            "jump to self"
+#define RUN_TIME_LIMIT              "time limit"
+#define RUN_INSTRUCTION_LIMIT       "instruction limit"
+
+// Limits and halt conditions of a run, 0 means unlimited
+struct RunOptions {
+    uint64_t maxInstructions = 0;   // Per hart
+    double maxSeconds = 0;
+    uint32_t quantum = 0;           // Run harts interleaved if not 0
+    bool hasHaltAddress = false;    // Needs a single hart or a quantum
+    uint32_t haltAddress = 0;
+    bool isHaltOnLoop = false;
+};
+
+struct RunResult {
+    const char *reason;
+    std::vector<uint64_t> hartInstructions;
+    uint64_t instructions;          // Sum over all harts
+    double seconds;                 // Wall-clock time of the run
+};
+
+// Runs a machine without a GUI until firmware exits through semihosting,
+// a limit is reached or a halt condition is met. A single hart runs on the
+// calling thread, several harts run through Smp
+class Runner {
+public:
+    Runner(Smp *smp, const RunOptions &options);
+
+    RunResult run(void);
+
+private:
+    // Checks for a guest exit and halt conditions after every instruction
+    // and the clock every RUNNER_CHECK_INTERVAL instructions
+    const char *runSingleHart(uint64_t *instructions);
+
+    // Interleaved harts stop on the instruction that exits or halts, only
+    // the wall-clock limit is polled from the side. Free running threads
+    // are stopped once polling notices an exit or the limit
+    const char *runMultipleHarts(void);
+
+    Smp *smp;
+    RunOptions options;
+};
+
+#endif // RUNNER_H
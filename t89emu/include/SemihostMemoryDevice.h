@@ -0,0 +1,84 @@
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+
+#include "Architecture.h"
+#include "Bus.h"
+#include "MemoryDevice.h"
+
+#ifndef SEMIHOSTMEMORYDEVICE_H
+#define SEMIHOSTMEMORYDEVICE_H
+
+// Size and offsets do not change across Semihost devices
+#define SEMIHOST_SIZE               0x18
+
+#define SEMIHOST_COMMAND_OFFSET     0x0 // Write runs a command
+#define SEMIHOST_ARG0_OFFSET        0x4
+#define SEMIHOST_ARG1_OFFSET        0x8
+#define SEMIHOST_ARG2_OFFSET        0xc
+#define SEMIHOST_RESULT_OFFSET      0x10 // Read only
+#define SEMIHOST_RESULT_HI_OFFSET   0x14 // Read only
+
+// Commands
+#define SEMIHOST_EXIT               1 // exit(ARG0)
+#define SEMIHOST_WRITE              2 // write(fd = ARG0, buf = ARG1, len = ARG2)
+#define SEMIHOST_TIME               3 // Host monotonic time in ns
+
+class InputLog;
+
+// Returned by commands that fail
+#define SEMIHOST_ERROR              0xffffffff
+
+// Host copies are done in chunks of this size
+#define SEMIHOST_CHUNK_SIZE         4096
+
+// Channel between firmware and the host. Firmware stores the arguments,
+// then the command, and reads the result once the store completes
+class SemihostMemoryDevice : public MemoryDevice {
+public:
+    SemihostMemoryDevice(uint32_t base, uint32_t size, Bus *bus);
+
+    uint32_t read(uint32_t addr, uint32_t size, uint32_t *readValue);
+    uint32_t write(uint32_t addr, uint32_t value, uint32_t size);
+
+    // Set once firmware runs the exit command, runners poll it to end the
+    // run early
+    inline bool hasExited(void) {
+        return isExited.load(std::memory_order_relaxed);
+    }
+    uint32_t getExitCode(void);
+
+    // Append console writes (fd 1 and 2) to output instead of the host's
+    // stdout/stderr, nullptr restores host output
+    void captureOutput(std::string *output);
+
+    // Pass host time reads through a log to record or replay them, nullptr
+    // reads host time directly
+    void setInputLog(InputLog *log);
+
+    // Restoring a state saved before the exit command clears the exit
+    void saveState(std::vector<uint8_t> &state);
+    void restoreState(const std::vector<uint8_t> &state);
+
+private:
+    // Copy len bytes at guest address buf to a host file descriptor,
+    // returns the bytes written or SEMIHOST_ERROR
+    uint32_t writeHost(uint32_t fd, uint32_t buf, uint32_t len);
+
+    void setResult(uint64_t result);
+
+    std::atomic<bool> isExited;
+    uint32_t exitCode;
+    std::chrono::steady_clock::time_point startTime;
+    InputLog *inputLog;
+
+    // Harts on other threads may write at the same time
+    std::string *capturedOutput;
+    std::mutex captureLock;
+
+    Bus *bus;
+};
+
+#endif // SEMIHOSTMEMORYDEVICE_H
@@ -0,0 +1,93 @@
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#ifndef SMP_H
+#define SMP_H
+
+#include "Mcu.h"
+
+// Instructions each hart executes per turn in interleaved mode
+#define SMP_DEFAULT_QUANTUM         1000
+
+// Hart 0 instructions between checks of the wall-clock limit
+#define SMP_CLOCK_CHECK_INTERVAL    65536
+
+// Why runInterleaved() returned
+#define SMP_STOP_LIMIT              0 // Every hart ran maxInstructions
+#define SMP_STOP_EXIT               1 // Firmware exited through semihosting
+#define SMP_STOP_HALT_ADDRESS       2 // Hart 0 reached the halt address
+#define SMP_STOP_JUMP_TO_SELF       3 // Hart 0 jumped to itself
+#define SMP_STOP_REQUESTED          4 // stop() was called
+#define SMP_STOP_TIME_LIMIT         5 // maxSeconds of wall-clock time passed
+
+// Conditions on hart 0 that end an interleaved run, and a wall-clock limit
+// (0 for none) checked on the running thread between turns
+struct HaltConditions {
+    bool hasHaltAddress = false;
+    uint32_t haltAddress = 0;
+    bool isHaltOnLoop = false;
+    double maxSeconds = 0;
+};
+
+// A machine with several harts sharing one bus. Hart 0 owns the memory and
+// devices, the other harts are created on top of it. Every hart starts
+// at the entry point, firmware tells them apart with mhartid
+class Smp {
+public:
+    Smp(uint32_t romBase, uint32_t ramBase, uint32_t entryPc,
+        uint32_t numHarts);
+    ~Smp();
+
+    // Run every hart on its own host thread. Harts stop when stop() is
+    // called or after executing maxInstructions each (0 runs until stopped).
+    // Harts other than hart 0 sleep while they wait in WFI, and count the
+    // cycles hart 0 ran meanwhile. They end their run when hart 0 does,
+    // since hart 0 drives mcycle
+    void start(uint64_t maxInstructions);
+
+    // Deterministic alternative to start(). All harts run on the calling
+    // thread in a fixed round robin order (hart 0 first), each executing
+    // quantum instructions per turn. A hart waiting in WFI skips its turn
+    // but is counted as having run it. Returns once every hart executed
+    // maxInstructions (0 runs until stopped), right after the instruction
+    // that exits through semihosting or meets a halt condition, within
+    // SMP_CLOCK_CHECK_INTERVAL instructions of passing halt.maxSeconds, or
+    // when stop() is called from another thread. Returns the reason
+    // (SMP_STOP_*). The schedule only depends on the quantum, so runs with
+    // the same inputs repeat exactly and stop on the same instruction.
+    // Smaller quanta interleave more finely at the cost of more switching
+    // between harts
+    uint32_t runInterleaved(uint64_t maxInstructions, uint32_t quantum,
+                            const HaltConditions &halt = HaltConditions());
+
+    // Request all harts to stop and wait for their threads to exit
+    void stop(void);
+
+    // Wait for all hart threads to exit without requesting a stop
+    void join(void);
+
+    bool isRunning(void);
+
+    Mcu *getHart(uint32_t hartId);
+    uint32_t getNumHarts(void);
+
+    // Instructions executed by a hart, including the ones of earlier runs
+    uint64_t getInstructionCount(uint32_t hartId);
+
+private:
+    void runHart(uint32_t hartId, uint64_t maxInstructions);
+
+    std::vector<Mcu *> harts;
+    std::vector<std::thread> threads;
+    std::vector<uint64_t> instructionCounts;
+    std::atomic<bool> isStopping;
+
+    // Set when hart 0 stops advancing mcycle, ends the wait of idle harts
+    std::atomic<bool> isClockStopped;
+    std::atomic<uint32_t> runningHarts;
+};
+
+#endif // SMP_H
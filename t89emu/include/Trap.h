@@ -11,8 +11,14 @@ public:
     Trap(void);
     ~Trap();
 
+    // Take an exception or interrupt in M-mode, or in S-mode if it is
+    // delegated. tval is the faulting address for memory exceptions
     void takeTrap(Csr *csr, ProgramCounter *pc, NextPc *nextPc,
-                  uint32_t mcause);
+                  uint32_t mcause, uint32_t tval = 0);
+
+private:
+    void takeSupervisorTrap(Csr *csr, ProgramCounter *pc, NextPc *nextPc,
+                            uint32_t scause, uint32_t tval);
 };
 
 #endif // TRAP_H
\ No newline at end of file
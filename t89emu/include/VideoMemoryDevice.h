@@ -1,17 +1,38 @@
 #include <stdint.h>
+#include <utility>
+#include <vector>
 
+#include "EventScheduler.h"
 #include "MemoryDevice.h"
+#include "PlicMemoryDevice.h"
 
 #ifndef VIDEO_MEMORYDEVICE_H
 #define VIDEO_MEMORYDEVICE_H
 
 #define VGA_TEXT_MODE                   1
-#define GRAPHICS_MODE                   2
+#define GRAPHICS_MODE                   2 // 32-bit RGBA
+#define GRAPHICS_MODE_RGB565            3 // 16-bit RGB565
+#define GRAPHICS_MODE_INDEXED           4 // 8-bit palette index
+
+// 256 RGBA palette entries follow the pixel buffer pages
+#define VIDEO_PALETTE_SIZE              (256 * 4)
+
+// Video controller registers
+#define VIDEO_CONTROLLER_SIZE           16
+#define VIDEO_MODE_OFFSET               0x0 // 1 byte
+#define VIDEO_PAGE_OFFSET               0x1 // 1 byte, write requests a flip
+#define VIDEO_FLIP_PENDING_OFFSET       0x2 // 1 byte, read only
+#define VIDEO_NUM_PAGES_OFFSET          0x3 // 1 byte, read only
+#define VIDEO_VBLANK_CYCLES_OFFSET      0x4 // 4 bytes, 0 disables vblank
+#define VIDEO_FRAME_COUNT_OFFSET        0x8 // 4 bytes, read only
 
 class VideoMemoryDevice : public MemoryDevice {
 public:
     VideoMemoryDevice(uint32_t base, uint32_t size, uint32_t gWidth,
-                      uint32_t gHeight, uint32_t tWidth, uint32_t tHeight);
+                      uint32_t gHeight, uint32_t tWidth, uint32_t tHeight,
+                      uint32_t numPages, uint32_t vblankCycles,
+                      EventScheduler *scheduler, PlicMemoryDevice *plic,
+                      uint32_t irq);
     
     uint32_t read(uint32_t addr, uint32_t size, uint32_t *readValue);
     uint32_t write(uint32_t addr, uint32_t value, uint32_t size);
@@ -21,11 +42,61 @@ public:
     uint32_t getTWidth(void);
     uint32_t getTHeight(void);
 
+    uint32_t writeBlock(uint32_t addr, const uint8_t *src, uint32_t size);
+
+    // A pending page flip is part of the state, the frame is redrawn
+    void saveState(std::vector<uint8_t> &state);
+    void restoreState(const std::vector<uint8_t> &state);
+
+    // Page flipping
+    uint8_t *getPixelBuffer(uint32_t page);
+    uint32_t getDisplayPage(void);
+
+    // Converts the rows of the displayed page that changed since the last
+    // call to RGBA. Returns the RGBA frame, dirtySpans is filled with
+    // (first row, number of rows) pairs that need uploading
+    uint8_t *presentFrame(
+        std::vector<std::pair<uint32_t, uint32_t>> &dirtySpans);
+
+    static bool isGraphicsMode(uint32_t mode);
+
 private:
+    uint32_t writeController(uint32_t offset, uint32_t value);
+    uint32_t getBytesPerPixel(void);
+    void markDirty(uint32_t offset, uint32_t size);
+    void markAllDirty(void);
+    void expandRow(uint32_t page, uint32_t row);
+    void scheduleVblank(void);
+    void vblank(void);
+
+    // Show the pending page, if a flip was requested
+    void flipPage(void);
+
     uint32_t gWidth; // Graphics Mode Width
     uint32_t gHeight;
     uint32_t tWidth; // Text Mode Width
     uint32_t tHeight;
+    uint32_t numPages;
+    uint32_t pageSize; // Sized for 32-bit pixels in every mode
+    uint32_t pixelOffset;
+    uint32_t paletteOffset;
+
+    // One bit per row and page, set when guest writes change a row
+    std::vector<uint64_t> dirtyRows;
+    uint32_t rowWords;
+
+    // RGBA frame for modes that need expanding
+    std::vector<uint32_t> frame;
+    uint32_t presentedPage;
+    uint32_t presentedMode;
+
+    EventScheduler *scheduler;
+    PlicMemoryDevice *plic;
+    uint32_t irq;
+
+    uint32_t pendingPage; // Page shown after the next vblank
+    uint32_t vblankGeneration; // Invalidates vblanks scheduled before a
+                               // change of refresh rate
 };
 
-#endif // VIDEO_MEMORYDEVICE_H
\ No newline at end of file
+#endif // VIDEO_MEMORYDEVICE_H
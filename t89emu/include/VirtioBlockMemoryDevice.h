@@ -0,0 +1,133 @@
+#include <stdint.h>
+
+#include "Architecture.h"
+#include "Bus.h"
+#include "MemoryDevice.h"
+#include "PlicMemoryDevice.h"
+
+#ifndef VIRTIOBLOCKMEMORYDEVICE_H
+#define VIRTIOBLOCKMEMORYDEVICE_H
+
+// Virtio over MMIO (virtio spec v1.1, section 4.2), modern interface only
+#define VIRTIO_MMIO_SIZE                    0x108
+
+#define VIRTIO_MMIO_MAGIC_VALUE             0x000
+#define VIRTIO_MMIO_VERSION                 0x004
+#define VIRTIO_MMIO_DEVICE_ID               0x008
+#define VIRTIO_MMIO_VENDOR_ID               0x00c
+#define VIRTIO_MMIO_DEVICE_FEATURES         0x010
+#define VIRTIO_MMIO_DEVICE_FEATURES_SEL     0x014
+#define VIRTIO_MMIO_DRIVER_FEATURES         0x020
+#define VIRTIO_MMIO_DRIVER_FEATURES_SEL     0x024
+#define VIRTIO_MMIO_QUEUE_SEL               0x030
+#define VIRTIO_MMIO_QUEUE_NUM_MAX           0x034
+#define VIRTIO_MMIO_QUEUE_NUM               0x038
+#define VIRTIO_MMIO_QUEUE_READY             0x044
+#define VIRTIO_MMIO_QUEUE_NOTIFY            0x050
+#define VIRTIO_MMIO_INTERRUPT_STATUS        0x060
+#define VIRTIO_MMIO_INTERRUPT_ACK           0x064
+#define VIRTIO_MMIO_STATUS                  0x070
+#define VIRTIO_MMIO_QUEUE_DESC_LOW          0x080
+#define VIRTIO_MMIO_QUEUE_DESC_HIGH         0x084
+#define VIRTIO_MMIO_QUEUE_DRIVER_LOW        0x090
+#define VIRTIO_MMIO_QUEUE_DRIVER_HIGH       0x094
+#define VIRTIO_MMIO_QUEUE_DEVICE_LOW        0x0a0
+#define VIRTIO_MMIO_QUEUE_DEVICE_HIGH       0x0a4
+#define VIRTIO_MMIO_CONFIG_GENERATION       0x0fc
+#define VIRTIO_MMIO_CONFIG                  0x100
+
+#define VIRTIO_MMIO_MAGIC                   0x74726976 // "virt"
+#define VIRTIO_MMIO_VENDOR                  0x65393874 // "t89e"
+#define VIRTIO_MMIO_INT_VRING               0x1
+
+// A device id of 0 marks an empty slot until an image is attached
+#define VIRTIO_ID_NONE                      0
+#define VIRTIO_ID_BLOCK                     2
+
+#define VIRTIO_STATUS_FEATURES_OK           8
+
+#define VIRTIO_F_VERSION_1                  32
+#define VIRTIO_BLK_F_RO                     5
+#define VIRTIO_BLK_F_FLUSH                  9
+
+#define VIRTQ_DESC_F_NEXT                   1
+#define VIRTQ_DESC_F_WRITE                  2
+
+#define VIRTIO_BLK_T_IN                     0
+#define VIRTIO_BLK_T_OUT                    1
+#define VIRTIO_BLK_T_FLUSH                  4
+#define VIRTIO_BLK_T_GET_ID                 8
+
+#define VIRTIO_BLK_S_OK                     0
+#define VIRTIO_BLK_S_IOERR                  1
+#define VIRTIO_BLK_S_UNSUPP                 2
+
+#define VIRTIO_BLK_SECTOR_SIZE              512
+#define VIRTIO_BLK_ID_BYTES                 20
+
+// Only a single request queue is exposed
+#define VIRTIO_BLK_QUEUE_SIZE               128
+
+class VirtioBlockMemoryDevice : public MemoryDevice {
+public:
+    VirtioBlockMemoryDevice(uint32_t base, uint32_t size, Bus *bus,
+                            PlicMemoryDevice *plic, uint32_t irq);
+    ~VirtioBlockMemoryDevice();
+
+    uint32_t read(uint32_t addr, uint32_t size, uint32_t *readValue);
+    uint32_t write(uint32_t addr, uint32_t value, uint32_t size);
+
+    // Memory map a host image file as the backing store of the disk. A
+    // copy on write disk is writable by the guest, but its writes never
+    // reach the file, so several machines or forked runs can share one image
+    bool attachImage(const char *path, bool isCopyOnWrite = false);
+
+    // Queue positions are part of the state, disk contents are not
+    void saveState(std::vector<uint8_t> &state);
+    void restoreState(const std::vector<uint8_t> &state);
+
+private:
+    struct VirtqDesc {
+        uint64_t addr;
+        uint32_t len;
+        uint16_t flags;
+        uint16_t next;
+    };
+
+    struct VirtqUsedElem {
+        uint32_t id;
+        uint32_t len;
+    };
+
+    struct VirtioBlkReqHeader {
+        uint32_t type;
+        uint32_t reserved;
+        uint64_t sector;
+    };
+
+    void reset(void);
+    void processQueue(void);
+    void processRequest(uint16_t head, uint32_t *written);
+    uint8_t transferData(uint32_t type, uint64_t sector, VirtqDesc *data,
+                         uint32_t numData, uint32_t *written);
+    uint8_t writeId(VirtqDesc *data, uint32_t numData, uint32_t *written);
+    uint64_t getDeviceFeatures(void);
+    uint32_t *getRegister(uint32_t offset);
+
+    Bus *bus;
+    PlicMemoryDevice *plic;
+    uint32_t irq;
+
+    // Memory mapped host image
+    uint8_t *image;
+    uint64_t imageSize;
+    bool isReadOnly;
+    bool isCopyOnWrite;
+
+    // Virtqueue state, ring addresses live in the register file
+    uint64_t driverFeatures;
+    uint16_t lastAvailIdx;
+    uint16_t usedIdx;
+};
+
+#endif // VIRTIOBLOCKMEMORYDEVICE_H
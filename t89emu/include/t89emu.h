@@ -0,0 +1,99 @@
+#ifndef T89EMU_H
+#define T89EMU_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// C interface of libt89emu, for driving machines from other languages
+// through FFI. Existing functions keep their signatures and behavior,
+// additions raise T89EMU_API_VERSION. A machine may be used by one thread at
+// a time, different machines can be used from different threads
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define T89EMU_API_VERSION          1
+
+// Return values of functions that can fail
+#define T89EMU_OK                   0
+#define T89EMU_ERROR_ARGUMENT       -1 // Invalid handle, hart or register
+#define T89EMU_ERROR_ELF            -2 // Not a loadable firmware image
+#define T89EMU_ERROR_NO_FIRMWARE    -3 // No firmware loaded yet
+#define T89EMU_ERROR_ACCESS         -4 // Memory access faulted
+#define T89EMU_ERROR_SNAPSHOT       -5 // Snapshot of another machine
+
+// Why t89emu_run returned
+#define T89EMU_STOP_BUDGET          0 // Executed the instruction budget
+#define T89EMU_STOP_BREAKPOINT      1 // A hart reached a breakpoint
+#define T89EMU_STOP_EXIT            2 // Firmware exited through semihosting
+
+// Register numbers of t89emu_read_register/t89emu_write_register
+#define T89EMU_REG_X0               0  // x0-x31 are 0-31
+#define T89EMU_REG_PC               32
+#define T89EMU_REG_F0               33 // f0-f31 are 33-64
+
+typedef struct t89emu_image t89emu_image;
+typedef struct t89emu_machine t89emu_machine;
+typedef struct t89emu_snapshot t89emu_snapshot;
+
+uint32_t t89emu_api_version(void);
+
+// A parsed firmware image. Images can be loaded into any number of machines
+// without parsing the file again. Loading only reads the image, so machines
+// on different threads may load the same image at once. An image must
+// outlive the machines it is loaded into. Returns NULL if the file is not a
+// loadable firmware image
+t89emu_image *t89emu_image_open(const char *path);
+void t89emu_image_close(t89emu_image *image);
+
+// Machines start without firmware, loading firmware builds the harts,
+// memory and devices. Loading again replaces them, which also drops
+// breakpoints and invalidates snapshots of the machine
+t89emu_machine *t89emu_create(uint32_t num_harts);
+void t89emu_destroy(t89emu_machine *machine);
+int t89emu_load_elf(t89emu_machine *machine, const char *path);
+int t89emu_load_image(t89emu_machine *machine, t89emu_image *image);
+
+// Run up to budget instructions per hart, 0 runs until a breakpoint or an
+// exit. Harts take turns executing one instruction each. Returns the stop
+// reason (T89EMU_STOP_*) or an error, and the instructions executed per
+// hart in executed if not NULL. A run never stops at the breakpoint it is
+// started on, so runs can continue past breakpoints
+int t89emu_run(t89emu_machine *machine, uint64_t budget, uint64_t *executed);
+
+// Exit code of firmware that stopped with T89EMU_STOP_EXIT
+int t89emu_get_exit_code(t89emu_machine *machine, uint32_t *exit_code);
+
+int t89emu_read_register(t89emu_machine *machine, uint32_t hart,
+                         uint32_t reg, uint32_t *value);
+int t89emu_write_register(t89emu_machine *machine, uint32_t hart,
+                          uint32_t reg, uint32_t value);
+int t89emu_read_csr(t89emu_machine *machine, uint32_t hart, uint32_t csr,
+                    uint32_t *value);
+int t89emu_write_csr(t89emu_machine *machine, uint32_t hart, uint32_t csr,
+                     uint32_t value);
+
+// Physical memory access. A block must lie within one device, ROM cannot be
+// written
+int t89emu_read_memory(t89emu_machine *machine, uint32_t addr, void *buf,
+                       size_t size);
+int t89emu_write_memory(t89emu_machine *machine, uint32_t addr,
+                        const void *buf, size_t size);
+
+// Breakpoints stop a run before any hart executes the instruction at addr
+int t89emu_add_breakpoint(t89emu_machine *machine, uint32_t addr);
+int t89emu_remove_breakpoint(t89emu_machine *machine, uint32_t addr);
+
+// Save the state of a machine, see Machine::Snapshot. A snapshot can be
+// restored any number of times into the machine it was taken from
+t89emu_snapshot *t89emu_snapshot_save(t89emu_machine *machine);
+int t89emu_snapshot_restore(t89emu_machine *machine,
+                            const t89emu_snapshot *snapshot);
+void t89emu_snapshot_free(t89emu_snapshot *snapshot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // T89EMU_H
@@ -48,6 +48,71 @@ uint32_t Alu::execute(uint32_t A, uint32_t B, int aluOp) {
         return (msb == 1);
     case SLTU: // sltu
         return (A < B); // Unsigned integer comparison
+    case MUL: // mul
+        return A * B;
+    case MULH: // mulh
+        return ((int64_t)(int32_t)A * (int64_t)(int32_t)B) >> 32;
+    case MULHSU: // mulhsu
+        return ((int64_t)(int32_t)A * (int64_t)(uint64_t)B) >> 32;
+    case MULHU: // mulhu
+        return ((uint64_t)A * (uint64_t)B) >> 32;
+    case DIV: // div
+        // Division by zero returns -1, overflow returns the dividend
+        if (B == 0) return 0xffffffff;
+        if (A == 0x80000000 && B == 0xffffffff) return A;
+        return (int32_t)A / (int32_t)B;
+    case DIVU: // divu
+        if (B == 0) return 0xffffffff;
+        return A / B;
+    case REM: // rem
+        // Remainder by zero returns the dividend, overflow returns 0
+        if (B == 0) return A;
+        if (A == 0x80000000 && B == 0xffffffff) return 0;
+        return (int32_t)A % (int32_t)B;
+    case REMU: // remu
+        if (B == 0) return A;
+        return A % B;
+    case SH1ADD: // sh1add
+        return (A << 1) + B;
+    case SH2ADD: // sh2add
+        return (A << 2) + B;
+    case SH3ADD: // sh3add
+        return (A << 3) + B;
+    case ANDN: // andn
+        return A & ~B;
+    case ORN: // orn
+        return A | ~B;
+    case XNOR: // xnor
+        return ~(A ^ B);
+    case CLZ: // clz, host builtins are undefined for 0
+        return A ? __builtin_clz(A) : 32;
+    case CTZ: // ctz
+        return A ? __builtin_ctz(A) : 32;
+    case CPOP: // cpop
+        return __builtin_popcount(A);
+    case SEXTB: // sext.b
+        return (int8_t)A;
+    case SEXTH: // sext.h
+        return (int16_t)A;
+    case ZEXTH: // zext.h
+        return (uint16_t)A;
+    case MAX: // max
+        return ((int32_t)A > (int32_t)B) ? A : B;
+    case MAXU: // maxu
+        return (A > B) ? A : B;
+    case MIN: // min
+        return ((int32_t)A < (int32_t)B) ? A : B;
+    case MINU: // minu
+        return (A < B) ? A : B;
+    case ROL: // rol
+        return (A << (B & 31)) | (A >> (-B & 31));
+    case ROR: // ror, rori
+        return (A >> (B & 31)) | (A << (-B & 31));
+    case REV8: // rev8
+        return __builtin_bswap32(A);
+    case ORCB: // orc.b, set the high bit of each non-zero byte then widen
+        msb = (((A & 0x7f7f7f7f) + 0x7f7f7f7f) | A) & 0x80808080;
+        return (msb >> 7) * 0xff;
     default: // Invalid opcode
         return 0;
     }
@@ -1,3 +1,4 @@
+#include "Alu.h"
 #include "AluControlUnit.h"
 
 AluControlUnit::AluControlUnit() {
@@ -13,16 +14,75 @@ AluControlUnit::~AluControlUnit() {
     
 }
 
-int AluControlUnit::getAluOperation(int opcode, int funct7, int funct3) {
+int AluControlUnit::getAluOperation(int opcode, int funct7, int funct3,
+                                    int rs2) {
     switch (opcode) {
     case ITYPE: // I-Type
         switch (funct3) {
-        case 5: //                         srli,    srai
+        case 1:
+            if (funct7 == 0b0110000) { // Zbb single operand instructions
+                switch (rs2) {
+                case 0b00000: return CLZ;
+                case 0b00001: return CTZ;
+                case 0b00010: return CPOP;
+                case 0b00100: return SEXTB;
+                case 0b00101: return SEXTH;
+                }
+                return ALU_ILLEGAL;
+            }
+            return SLL; // slli
+        case 5:
+            switch (funct7) {
+            case 0b0110000: return ROR; // rori
+            case 0b0110100: // rev8 is imm 0x698
+                return (rs2 == 0b11000) ? REV8 : ALU_ILLEGAL;
+            case 0b0010100: // orc.b is imm 0x287
+                return (rs2 == 0b00111) ? ORCB : ALU_ILLEGAL;
+            }
+            //                             srli,    srai
             return (funct7 == 0b0000000) ? 0b0101 : 0b0110;
         default: // all other I-Type instructions
             return this->iOperations[funct3];
         }
     case RTYPE: // R-Type
+        // mul, mulh, mulhsu, mulhu, div, divu, rem, remu follow funct3
+        if (funct7 == MULDIV_FUNCT7) {
+            return 0b1010 + funct3;
+        }
+
+        switch (funct7) {
+        case 0b0010000: // Zba shift and add
+            switch (funct3) {
+            case 2: return SH1ADD;
+            case 4: return SH2ADD;
+            case 6: return SH3ADD;
+            }
+            break;
+        case 0b0100000: // Inverted Zbb logic, sub and sra handled below
+            switch (funct3) {
+            case 4: return XNOR;
+            case 6: return ORN;
+            case 7: return ANDN;
+            }
+            break;
+        case 0b0000101: // min, minu, max, maxu
+            switch (funct3) {
+            case 4: return MIN;
+            case 5: return MINU;
+            case 6: return MAX;
+            case 7: return MAXU;
+            }
+            break;
+        case 0b0110000: // rol, ror
+            switch (funct3) {
+            case 1: return ROL;
+            case 5: return ROR;
+            }
+            return ALU_ILLEGAL;
+        case 0b0000100: // zext.h
+            return (funct3 == 4 && rs2 == 0) ? ZEXTH : ALU_ILLEGAL;
+        }
+
         switch (funct3) {
         case 0: //                         add,     sub
             return (funct7 == 0b0000000) ? 0b0000 : 0b0001;
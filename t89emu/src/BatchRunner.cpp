@@ -0,0 +1,269 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <thread>
+
+#include "BatchRunner.h"
+#include "ElfParser.h"
+#include "Machine.h"
+
+#define FNV_OFFSET_BASIS            0xcbf29ce484222325ULL
+#define FNV_PRIME                   0x100000001b3ULL
+
+BatchRunner::BatchRunner(uint32_t numWorkers) : numWorkers(numWorkers) {
+    if (this->numWorkers == 0) {
+        this->numWorkers = std::thread::hardware_concurrency();
+    }
+    if (this->numWorkers == 0) { // Core count is unknown
+        this->numWorkers = 1;
+    }
+}
+
+bool BatchRunner::loadManifest(const char *path,
+                               const RunOptions &defaults) {
+    std::ifstream manifest(path);
+    if (!manifest) {
+        fprintf(stderr, "Error: could not open %s\n", path);
+        return false;
+    }
+
+    std::string line;
+    uint32_t lineNumber = 0;
+    while (std::getline(manifest, line)) {
+        lineNumber++;
+        std::istringstream fields(line);
+        std::string field;
+        if (!(fields >> field) || field[0] == '#') {
+            continue;
+        }
+
+        BatchJob job;
+        job.options = defaults;
+        job.elfPath = field;
+        job.name = field;
+        bool isValid = true;
+        while (isValid && fields >> field) {
+            size_t split = field.find('=');
+            if (split == std::string::npos) {
+                isValid = false;
+                break;
+            }
+            std::string key = field.substr(0, split);
+            std::string value = field.substr(split + 1);
+            const char *str = value.c_str();
+            if (key == "name") {
+                job.name = value;
+            } else if (key == "harts") {
+                job.numHarts = strtoul(str, nullptr, 0);
+            } else if (key == "budget") {
+                job.options.maxInstructions = strtoull(str, nullptr, 0);
+            } else if (key == "timeout") {
+                job.options.maxSeconds = strtod(str, nullptr);
+            } else if (key == "quantum") {
+                job.options.quantum = strtoul(str, nullptr, 0);
+            } else if (key == "keys") {
+                job.keyScriptPath = value;
+            } else if (key == "disk") {
+                job.diskPath = value;
+            } else {
+                isValid = false;
+            }
+        }
+
+        bool hasHaltCondition =
+            job.options.hasHaltAddress || job.options.isHaltOnLoop;
+        if (job.numHarts == 0 || job.numHarts > CLINT_MAX_HARTS ||
+            (hasHaltCondition && job.numHarts != 1 &&
+             !job.options.quantum)) {
+            isValid = false;
+        }
+
+        // ElfParser exits the process on a missing file, so check up front
+        // that the image at least opens
+        if (isValid && !std::ifstream(job.elfPath.c_str())) {
+            fprintf(stderr, "Error: could not open %s\n",
+                    job.elfPath.c_str());
+            isValid = false;
+        }
+        if (!isValid) {
+            fprintf(stderr, "%s:%u: invalid job: %s\n", path, lineNumber,
+                    line.c_str());
+            return false;
+        }
+
+        addJob(job);
+    }
+
+    return true;
+}
+
+void BatchRunner::addJob(const BatchJob &job) {
+    jobs.push_back(job);
+}
+
+void BatchRunner::run() {
+    results.assign(jobs.size(), BatchResult());
+
+    // Each firmware image is parsed once and shared by the machines of all
+    // jobs that run it
+    std::map<std::string, ElfParser *> elfParsers;
+    for (const BatchJob &job : jobs) {
+        if (!elfParsers.count(job.elfPath)) {
+            elfParsers[job.elfPath] = new ElfParser(job.elfPath.c_str());
+        }
+    }
+
+    // Workers take the next job until none are left, so long jobs do not
+    // hold up the rest of the batch
+    std::atomic<size_t> nextJob(0);
+    auto worker = [&]() {
+        size_t index;
+        while ((index = nextJob.fetch_add(1)) < jobs.size()) {
+            const BatchJob &job = jobs[index];
+            results[index] = runJob(job, elfParsers[job.elfPath]);
+        }
+    };
+
+    uint32_t threadCount = numWorkers;
+    if (threadCount > jobs.size()) {
+        threadCount = jobs.size();
+    }
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < threadCount; i++) {
+        workers.emplace_back(worker);
+    }
+    for (std::thread &thread : workers) {
+        thread.join();
+    }
+
+    for (auto &elfParser : elfParsers) {
+        delete elfParser.second;
+    }
+}
+
+BatchResult BatchRunner::runJob(const BatchJob &job, ElfParser *elfParser) {
+    BatchResult result;
+
+    Machine *machine = new Machine(elfParser, job.numHarts);
+    Mcu *mcu = machine->getMcu();
+
+    std::string output;
+    SemihostMemoryDevice *semihost = mcu->getSemihostDevice();
+    semihost->captureOutput(&output);
+
+    // Jobs may share an image, so each one writes to its own copy
+    if (!job.diskPath.empty() &&
+        !mcu->getVirtioBlockDevice()->attachImage(job.diskPath.c_str(),
+                                                  true)) {
+        result.status = "could not attach disk image";
+    } else if (!job.keyScriptPath.empty() &&
+               !mcu->getKeyboardDevice()->loadScript(
+                   job.keyScriptPath.c_str())) {
+        result.status = "could not load keyboard script";
+    } else {
+        Runner runner(machine->getSmp(), job.options);
+        RunResult run = runner.run();
+        result.status = run.reason;
+        result.instructions = run.instructions;
+        result.seconds = run.seconds;
+    }
+
+    if (semihost->hasExited()) {
+        result.hasExitCode = true;
+        result.exitCode = semihost->getExitCode();
+    }
+    semihost->captureOutput(nullptr);
+    result.outputHash = hashOutput(output);
+    result.outputSize = output.size();
+
+    delete machine;
+    return result;
+}
+
+// Write a string as a JSON string literal
+static void writeJsonString(FILE *file, const std::string &str) {
+    fputc('"', file);
+    for (unsigned char c : str) {
+        if (c == '"' || c == '\\') {
+            fprintf(file, "\\%c", c);
+        } else if (c < 0x20) {
+            fprintf(file, "\\u%04x", c);
+        } else {
+            fputc(c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+bool BatchRunner::writeReport(const char *path) {
+    bool isStdout = std::string(path) == "-";
+    FILE *file = isStdout ? stdout : fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Error: could not open %s\n", path);
+        return false;
+    }
+
+    fprintf(file, "{\n  \"workers\": %u,\n  \"failed\": %u,\n  \"jobs\": [",
+            numWorkers, getNumFailed());
+    for (size_t i = 0; i < results.size(); i++) {
+        const BatchJob &job = jobs[i];
+        const BatchResult &result = results[i];
+        double seconds = result.seconds;
+
+        fprintf(file, "%s\n    {\"name\": ", i ? "," : "");
+        writeJsonString(file, job.name);
+        fprintf(file, ", \"elf\": ");
+        writeJsonString(file, job.elfPath);
+        fprintf(file, ", \"harts\": %u, \"status\": ", job.numHarts);
+        writeJsonString(file, result.status);
+        if (result.hasExitCode) {
+            fprintf(file, ", \"exit_code\": %u", result.exitCode);
+        } else {
+            fprintf(file, ", \"exit_code\": null");
+        }
+        fprintf(file,
+                ", \"instructions\": %llu, \"seconds\": %.6f"
+                ", \"mips\": %.2f, \"output_bytes\": %llu"
+                ", \"output_hash\": \"%016llx\"}",
+                (unsigned long long)result.instructions, seconds,
+                seconds ? result.instructions / seconds / 1e6 : 0.0,
+                (unsigned long long)result.outputSize,
+                (unsigned long long)result.outputHash);
+    }
+    fprintf(file, "\n  ]\n}\n");
+
+    if (!isStdout) {
+        fclose(file);
+    }
+    return true;
+}
+
+uint32_t BatchRunner::getNumFailed() {
+    uint32_t numFailed = 0;
+    for (const BatchResult &result : results) {
+        if (!result.hasExitCode || result.exitCode != 0) {
+            numFailed++;
+        }
+    }
+    return numFailed;
+}
+
+const std::vector<BatchJob> &BatchRunner::getJobs() {
+    return jobs;
+}
+
+const std::vector<BatchResult> &BatchRunner::getResults() {
+    return results;
+}
+
+uint64_t BatchRunner::hashOutput(const std::string &output) {
+    uint64_t hash = FNV_OFFSET_BASIS;
+    for (unsigned char c : output) {
+        hash ^= c;
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
@@ -96,7 +96,7 @@ VideoMemoryDevice *Bus::getVideoDevice() {
 
 #else
 
-Bus::Bus() {
+Bus::Bus() : isSerialized(false) {
     
 }
 
@@ -106,7 +106,8 @@ Bus::~Bus() {
 
 uint32_t Bus::read(uint32_t addr, uint32_t accessSize, uint32_t *readValue) {
     for (MemoryDevice *device : devices) {
-        if (addr >= device->getBaseAddress() && addr <= device->getEndAddress()) {
+        if (addr >= device->getBaseAddress() && addr < device->getEndAddress()) {
+            DeviceGuard guard(this, device);
             return device->read(addr, accessSize, readValue);
         }
     }
@@ -116,7 +117,8 @@ uint32_t Bus::read(uint32_t addr, uint32_t accessSize, uint32_t *readValue) {
 
 uint32_t Bus::write(uint32_t addr, uint32_t data, uint32_t accessSize) {
     for (MemoryDevice *device : devices) {
-        if (addr >= device->getBaseAddress() && addr <= device->getEndAddress()) {
+        if (addr >= device->getBaseAddress() && addr < device->getEndAddress()) {
+            DeviceGuard guard(this, device);
             return device->write(addr, data, accessSize);
         }
     }
@@ -124,9 +126,89 @@ uint32_t Bus::write(uint32_t addr, uint32_t data, uint32_t accessSize) {
     return STORE_ACCESS_FAULT;
 }
 
+uint32_t Bus::readBlock(uint32_t addr, uint8_t *dst, uint32_t size) {
+    for (MemoryDevice *device : devices) {
+        if (device->containsBlock(addr, size)) {
+            DeviceGuard guard(this, device);
+            return device->readBlock(addr, dst, size);
+        }
+    }
+
+    return LOAD_ACCESS_FAULT;
+}
+
+uint32_t Bus::writeBlock(uint32_t addr, const uint8_t *src, uint32_t size) {
+    for (MemoryDevice *device : devices) {
+        if (device->containsBlock(addr, size)) {
+            DeviceGuard guard(this, device);
+            return device->writeBlock(addr, src, size);
+        }
+    }
+
+    return STORE_ACCESS_FAULT;
+}
+
+uint32_t Bus::atomicOperation(uint32_t addr, uint32_t operation,
+                              uint32_t operand, uint32_t *readValue) {
+    for (MemoryDevice *device : devices) {
+        if (device->containsBlock(addr, WORD)) {
+            DeviceGuard guard(this, device);
+            return device->atomicOperation(addr, operation, operand,
+                                           readValue);
+        }
+    }
+
+    return STORE_ACCESS_FAULT;
+}
+
+uint32_t Bus::compareAndSwap(uint32_t addr, uint32_t expected, uint32_t value,
+                             bool *isSwapped) {
+    for (MemoryDevice *device : devices) {
+        if (device->containsBlock(addr, WORD)) {
+            DeviceGuard guard(this, device);
+            return device->compareAndSwap(addr, expected, value, isSwapped);
+        }
+    }
+
+    return STORE_ACCESS_FAULT;
+}
+
 int Bus::addDevice(MemoryDevice *device) {
     devices.push_back(device);
     return devices.size() - 1;
 }
 
+std::vector<MemoryDevice *> &Bus::getDevices() {
+    return devices;
+}
+
+void Bus::setSerialized(bool isSerialized) {
+    this->isSerialized = isSerialized;
+}
+
+void Bus::lockDevices() {
+    if (isSerialized) {
+        deviceLock.lock();
+    }
+}
+
+void Bus::unlockDevices() {
+    if (isSerialized) {
+        deviceLock.unlock();
+    }
+}
+
+Bus::DeviceGuard::DeviceGuard(Bus *bus, MemoryDevice *device)
+    : bus((bus->isSerialized && !device->isThreadSafe()) ? bus : nullptr) {
+    if (this->bus) {
+        this->bus->deviceLock.lock();
+    }
+}
+
+Bus::DeviceGuard::~DeviceGuard() {
+    if (bus) {
+        bus->deviceLock.unlock();
+    }
+}
+
 #endif // BUS_EXPERIMENTAL
\ No newline at end of file
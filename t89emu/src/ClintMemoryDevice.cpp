@@ -2,7 +2,9 @@
 #include "ClintMemoryDevice.h"
 
 ClintMemoryDevice::ClintMemoryDevice(uint32_t base, uint32_t size)
-    : MemoryDevice::MemoryDevice(base, size), interruptType(0) {
+    : MemoryDevice::MemoryDevice(base, size),
+      wakeGeneration(0),
+      wakeCycle(UINT64_MAX) {
     
 }
 
@@ -13,11 +15,18 @@ uint32_t ClintMemoryDevice::read(uint32_t addr, uint32_t size,
         return LOAD_ADDRESS_MISALIGNED;
     }
 
+    // Registers are read by every hart thread, so accesses are atomic
+    uint8_t *reg = &mem[getRegisterOffset(addr)];
+
     // Invalid memory size access handled by memory control unit
     switch (size) {
-    case BYTE: *read_value = *((uint8_t *)getAddress(addr)); break;
-    case HALFWORD: *read_value = *((uint16_t *)getAddress(addr)); break;
-    case WORD: *read_value = *((uint32_t *)getAddress(addr)); break;
+    case BYTE: *read_value = __atomic_load_n(reg, __ATOMIC_RELAXED); break;
+    case HALFWORD:
+        *read_value = __atomic_load_n((uint16_t *)reg, __ATOMIC_RELAXED);
+        break;
+    case WORD:
+        *read_value = __atomic_load_n((uint32_t *)reg, __ATOMIC_RELAXED);
+        break;
     }
 
     return STATUS_OK;
@@ -29,56 +38,148 @@ uint32_t ClintMemoryDevice::write(uint32_t addr, uint32_t value,
     if (!checkAlignment(addr, size)) {
         return STORE_ADDRESS_MISALIGNED;
     }
+
+    uint8_t *reg = &mem[getRegisterOffset(addr)];
     
     switch (size) {
-    case BYTE: *((uint8_t *)getAddress(addr)) = value; break;
-    case HALFWORD: *((uint16_t *)getAddress(addr)) = value; break;
-    case WORD : *((uint32_t *)getAddress(addr)) = value; break;
+    case BYTE: __atomic_store_n(reg, value, __ATOMIC_RELAXED); break;
+    case HALFWORD:
+        __atomic_store_n((uint16_t *)reg, value, __ATOMIC_RELAXED);
+        break;
+    case WORD:
+        __atomic_store_n((uint32_t *)reg, value, __ATOMIC_RELAXED);
+        break;
+    }
+
+    // A new compare value or software interrupt may end a hart's WFI
+    uint32_t offset = reg - mem;
+    if (offset >= MSIP_ARRAY_OFFSET) {
+        wakeAll();
     }
     
     return STATUS_OK;
 }
 
-void ClintMemoryDevice::nextCycle(Csr *csr) {
-    // Increment 64-bit mcycle
+void ClintMemoryDevice::nextCycle(Csr *csr, uint32_t hartId) {
+    // Increment 64-bit mcycle, only hart 0 writes it
     uint64_t *mcycle = (uint64_t *)&mem[MCYCLE_OFFSET];
-    (*mcycle)++;
+    if (hartId == 0) {
+        uint64_t cycle = __atomic_load_n(mcycle, __ATOMIC_RELAXED) + 1;
+        __atomic_store_n(mcycle, cycle, __ATOMIC_RELAXED);
+
+        // Harts waiting for their timer are woken by the cycle reaching it
+        if (cycle >= __atomic_load_n(&wakeCycle, __ATOMIC_RELAXED)) {
+            wakeAll();
+        }
+    }
+
+    updatePending(csr, hartId);
+}
+
+void ClintMemoryDevice::updatePending(Csr *csr, uint32_t hartId) {
+    uint64_t cycle = getCycle();
 
     // Check for Timer interrupts
     // When mcycle >= mtimecmp, set pending timer interrupt
-    uint64_t *mtimecmp = (uint64_t *)&mem[MTIMECMP_OFFSET];
-    if (*mcycle >= *mtimecmp) csr->setMtip();
+    uint64_t *mtimecmp =
+        (uint64_t *)&mem[MTIMECMP_ARRAY_OFFSET + hartId * sizeof(uint64_t)];
+    if (cycle >= __atomic_load_n(mtimecmp, __ATOMIC_RELAXED)) csr->setMtip();
     else csr->resetMtip();
 
     // Check for software interrupts, if MSIP is 1
     // write MSIP to field designed in MIP register
-    uint32_t *msip = (uint32_t *)&mem[MSIP_OFFSET];
-    if (*msip == 1) csr->setMsip();
+    uint32_t *msip =
+        (uint32_t *)&mem[MSIP_ARRAY_OFFSET + hartId * sizeof(uint32_t)];
+    if (__atomic_load_n(msip, __ATOMIC_RELAXED) == 1) csr->setMsip();
+    else csr->resetMsip();
+}
+
+uint64_t ClintMemoryDevice::getCycle() {
+    return __atomic_load_n((uint64_t *)&mem[MCYCLE_OFFSET], __ATOMIC_RELAXED);
+}
+
+void ClintMemoryDevice::waitForInterrupt(Csr *csr, uint32_t hartId,
+                                         const std::atomic<bool> &isCancelled) {
+    std::unique_lock<std::mutex> lock(waitLock);
+    uint64_t generation = wakeGeneration;
+
+    // Checked under the lock, a write that raises the interrupt afterwards
+    // has to take the lock to wake this hart
+    updatePending(csr, hartId);
+    uint32_t enabled = csr->readCsr(CSR_MIE);
+    if (isCancelled || (csr->readCsr(CSR_MIP) & enabled)) {
+        return;
+    }
+
+    if (enabled & (1 << MIP_MTIP_MASK)) {
+        uint64_t *mtimecmp =
+            (uint64_t *)&mem[MTIMECMP_ARRAY_OFFSET + hartId * sizeof(uint64_t)];
+        uint64_t timecmp = __atomic_load_n(mtimecmp, __ATOMIC_RELAXED);
+        if (timecmp < wakeCycle) {
+            __atomic_store_n(&wakeCycle, timecmp, __ATOMIC_RELAXED);
+        }
+    }
+
+    waitCondition.wait(lock, [&] { return wakeGeneration != generation; });
+}
+
+void ClintMemoryDevice::wakeAll() {
+    std::lock_guard<std::mutex> lock(waitLock);
+
+    // Woken harts that still wait register their timer again
+    __atomic_store_n(&wakeCycle, UINT64_MAX, __ATOMIC_RELAXED);
+    wakeGeneration++;
+    waitCondition.notify_all();
 }
 
-bool ClintMemoryDevice::checkInterrupts(Csr *csr) {
-    // Verify Global Interrupts are enabled via MIA bit
-    // Later: Implement interrupt checks in S-mode
-    if (!csr->getMie()) {
+bool ClintMemoryDevice::checkInterrupts(Csr *csr, uint32_t hartId,
+                                        uint32_t *interruptType) {
+    (void)hartId; // Pending bits are already latched into mip
+
+    uint32_t pending = csr->readCsr(CSR_MIP) & csr->readCsr(CSR_MIE);
+    if (!pending) {
         return false;
     }
 
-    // Check for software interrupts
-    uint32_t *msip = (uint32_t *)&mem[MSIP_OFFSET];
-    if ((*msip == 1) && csr->getMsie()) {
-        interruptType = MACHINE_SOFTWARE_INTERRUPT;
-        return true;
+    // Interrupts taken in M-mode are enabled by MIE, or always when running
+    // below M-mode. Delegated interrupts are enabled by SIE in S-mode, or
+    // always in U-mode, and never interrupt M-mode
+    uint32_t privilegeLevel = csr->getPrivilegeLevel();
+    uint32_t mideleg = csr->readCsr(CSR_MIDELEG);
+    uint32_t enabled = 0;
+    if (privilegeLevel < MACHINE_MODE || csr->getMie()) {
+        enabled |= pending & ~mideleg;
+    }
+    if (privilegeLevel < SUPERVISOR_MODE ||
+        (privilegeLevel == SUPERVISOR_MODE && csr->getSie())) {
+        enabled |= pending & mideleg;
+    }
+    if (!enabled) {
+        return false;
     }
 
-    // Check for timer interrupts
-    if (csr->getMtip() && csr->getMtie()) {
-        interruptType = MACHINE_TIMER_INTERRUPT;
-        return true;
+    // Priority order: MEI, MSI, MTI, SEI, SSI, STI
+    static const uint32_t priority[] = {
+        MIP_MEIP_MASK, MIP_MSIP_MASK, MIP_MTIP_MASK,
+        MIP_SEIP_MASK, MIP_SSIP_MASK, MIP_STIP_MASK
+    };
+    for (uint32_t bit : priority) {
+        if (enabled & (1 << bit)) {
+            *interruptType = 0x80000000 | bit;
+            return true;
+        }
     }
 
     return false;
 }
 
-uint32_t ClintMemoryDevice::getInterruptType() {
-    return interruptType;
-}
\ No newline at end of file
+uint32_t ClintMemoryDevice::getRegisterOffset(uint32_t addr) {
+    uint32_t offset = addr - baseAddress;
+
+    if (offset >= MTIMECMP_OFFSET && offset < MTIMECMP_OFFSET + 8) {
+        return MTIMECMP_ARRAY_OFFSET + (offset - MTIMECMP_OFFSET);
+    } else if (offset >= MSIP_OFFSET && offset < MSIP_OFFSET + 4) {
+        return MSIP_ARRAY_OFFSET + (offset - MSIP_OFFSET);
+    }
+    return offset;
+}
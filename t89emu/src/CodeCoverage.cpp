@@ -0,0 +1,73 @@
+#include "CodeCoverage.h"
+
+#include <cstdio>
+#include <iostream>
+
+#include "Dwarf/DwarfParser.h"
+
+CodeCoverage::CodeCoverage(Smp *smp) : smp(smp) {
+    RomMemoryDevice *rom = smp->getHart(0)->getRomDevice();
+    romBase = rom->getBaseAddress();
+    executionMap.resize(rom->getDeviceSize() / 2);
+
+    for (uint32_t hartId = 0; hartId < smp->getNumHarts(); hartId++) {
+        smp->getHart(hartId)->setExecutionMap(executionMap.data());
+    }
+}
+
+CodeCoverage::~CodeCoverage() {
+    for (uint32_t hartId = 0; hartId < smp->getNumHarts(); hartId++) {
+        smp->getHart(hartId)->setExecutionMap(nullptr);
+    }
+}
+
+bool CodeCoverage::writeLcov(const char *elfPath, const char *lcovPath) {
+    ElfParser *elfParser = ElfParser::open(elfPath);
+    bool isDebuggable = elfParser && elfParser->isDebuggable();
+    delete elfParser;
+    if (!isDebuggable) {
+        std::cerr << "CodeCoverage: " << elfPath
+                  << " has no debug information\n";
+        return false;
+    }
+
+    DwarfParser dwarfParser(elfPath);
+    LineCoverage coverage;
+    dwarfParser.getLineCoverage(coverage, [this](uint32_t start,
+                                                 uint32_t end) {
+        return isExecuted(start, end);
+    });
+
+    FILE *file = fopen(lcovPath, "w");
+    if (!file) {
+        perror(lcovPath);
+        return false;
+    }
+
+    // One record per source file, instruction counts are not kept so hit
+    // lines count 1
+    fprintf(file, "TN:\n");
+    for (const auto &source : coverage) {
+        uint32_t numHit = 0;
+        fprintf(file, "SF:%s\n", source.first.c_str());
+        for (const auto &line : source.second) {
+            fprintf(file, "DA:%u,%u\n", line.first, line.second ? 1 : 0);
+            numHit += line.second;
+        }
+        fprintf(file, "LF:%zu\nLH:%u\nend_of_record\n", source.second.size(),
+                numHit);
+    }
+
+    return fclose(file) == 0;
+}
+
+bool CodeCoverage::isExecuted(uint32_t start, uint32_t end) {
+    for (uint32_t addr = start & ~1u; addr < end; addr += 2) {
+        uint32_t index = (addr - romBase) >> 1;
+        if (index < executionMap.size() && executionMap[index]) {
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,241 @@
+#include "CompressedDecoder.h"
+
+// Register numbers
+#define ZERO    0
+#define RA      1
+#define SP      2
+
+// Sign extend the low "bits" bits of value
+static inline uint32_t signExtend(uint32_t value, uint32_t bits) {
+    uint32_t mask = 1 << (bits - 1);
+    return (value ^ mask) - mask;
+}
+
+CompressedDecoder::CompressedDecoder() {
+
+}
+
+CompressedDecoder::~CompressedDecoder() {
+
+}
+
+uint32_t CompressedDecoder::expand(uint16_t instruction) {
+    switch (instruction & 0b11) {
+    case 0b00: return expandQuadrant0(instruction);
+    case 0b01: return expandQuadrant1(instruction);
+    case 0b10: return expandQuadrant2(instruction);
+    default: return 0; // Not a compressed instruction
+    }
+}
+
+uint32_t CompressedDecoder::expandQuadrant0(uint16_t instruction) {
+    uint32_t funct3 = (instruction >> 13) & 0b111;
+    uint32_t rdPrime = ((instruction >> 2) & 0b111) + 8; // rd' / rs2'
+    uint32_t rs1Prime = ((instruction >> 7) & 0b111) + 8;
+    uint32_t immediate;
+
+    switch (funct3) {
+    case 0b000: // c.addi4spn
+        immediate = ((instruction >> 7) & 0x30) |  // nzuimm[5:4]
+                    ((instruction >> 1) & 0x3c0) | // nzuimm[9:6]
+                    ((instruction >> 4) & 0x4) |   // nzuimm[2]
+                    ((instruction >> 2) & 0x8);    // nzuimm[3]
+        if (immediate == 0) {
+            return 0; // Also covers the all zero instruction
+        }
+        return encodeI(immediate, SP, 0b000, rdPrime, ITYPE);
+    case 0b010: // c.lw
+    case 0b011: // c.flw
+    case 0b110: // c.sw
+    case 0b111: // c.fsw
+        immediate = ((instruction >> 7) & 0x38) | // uimm[5:3]
+                    ((instruction >> 4) & 0x4) |  // uimm[2]
+                    ((instruction << 1) & 0x40);  // uimm[6]
+        switch (funct3) {
+        case 0b010:
+            return encodeI(immediate, rs1Prime, 0b010, rdPrime, LOAD);
+        case 0b011:
+            return encodeI(immediate, rs1Prime, 0b010, rdPrime, LOAD_FP);
+        case 0b110:
+            return encodeS(immediate, rdPrime, rs1Prime, 0b010);
+        default:
+            return encodeS(immediate, rdPrime, rs1Prime, 0b010, STORE_FP);
+        }
+    default: // Double precision loads/stores
+        return 0;
+    }
+}
+
+uint32_t CompressedDecoder::expandQuadrant1(uint16_t instruction) {
+    uint32_t funct3 = (instruction >> 13) & 0b111;
+    uint32_t rd = (instruction >> 7) & 0b11111;
+    uint32_t rdPrime = ((instruction >> 7) & 0b111) + 8;
+    uint32_t rs2Prime = ((instruction >> 2) & 0b111) + 8;
+    uint32_t immediate = signExtend(((instruction >> 7) & 0x20) | // imm[5]
+                                    ((instruction >> 2) & 0x1f),  // imm[4:0]
+                                    6);
+
+    switch (funct3) {
+    case 0b000: // c.addi (c.nop when rd is zero)
+        return encodeI(immediate, rd, 0b000, rd, ITYPE);
+    case 0b001: // c.jal
+    case 0b101: // c.j
+        immediate = ((instruction >> 1) & 0x800) | // offset[11]
+                    ((instruction >> 7) & 0x10) |  // offset[4]
+                    ((instruction >> 1) & 0x300) | // offset[9:8]
+                    ((instruction << 2) & 0x400) | // offset[10]
+                    ((instruction >> 1) & 0x40) |  // offset[6]
+                    ((instruction << 1) & 0x80) |  // offset[7]
+                    ((instruction >> 2) & 0xe) |   // offset[3:1]
+                    ((instruction << 3) & 0x20);   // offset[5]
+        return encodeJ(signExtend(immediate, 12),
+                       (funct3 == 0b001) ? RA : ZERO);
+    case 0b010: // c.li
+        return encodeI(immediate, ZERO, 0b000, rd, ITYPE);
+    case 0b011:
+        if (rd == SP) { // c.addi16sp
+            immediate = ((instruction >> 3) & 0x200) | // nzimm[9]
+                        ((instruction >> 2) & 0x10) |  // nzimm[4]
+                        ((instruction << 1) & 0x40) |  // nzimm[6]
+                        ((instruction << 4) & 0x180) | // nzimm[8:7]
+                        ((instruction << 3) & 0x20);   // nzimm[5]
+            if (immediate == 0) {
+                return 0;
+            }
+            return encodeI(signExtend(immediate, 10), SP, 0b000, SP, ITYPE);
+        }
+        // c.lui
+        if (immediate == 0) {
+            return 0;
+        }
+        return (immediate << 12) | (rd << 7) | LUI;
+    case 0b100:
+        switch ((instruction >> 10) & 0b11) {
+        case 0b00: // c.srli
+        case 0b01: // c.srai
+            if (instruction & 0x1000) {
+                return 0; // shamt[5] must be zero on RV32
+            }
+            immediate &= 0x1f;
+            if ((instruction >> 10) & 0b1) {
+                immediate |= 0x400; // srai
+            }
+            return encodeI(immediate, rdPrime, 0b101, rdPrime, ITYPE);
+        case 0b10: // c.andi
+            return encodeI(immediate, rdPrime, 0b111, rdPrime, ITYPE);
+        default:
+            if (instruction & 0x1000) {
+                return 0; // RV64 only
+            }
+            switch ((instruction >> 5) & 0b11) {
+            case 0b00: // c.sub
+                return encodeR(0b0100000, rs2Prime, rdPrime, 0b000, rdPrime,
+                               RTYPE);
+            case 0b01: // c.xor
+                return encodeR(0, rs2Prime, rdPrime, 0b100, rdPrime, RTYPE);
+            case 0b10: // c.or
+                return encodeR(0, rs2Prime, rdPrime, 0b110, rdPrime, RTYPE);
+            default: // c.and
+                return encodeR(0, rs2Prime, rdPrime, 0b111, rdPrime, RTYPE);
+            }
+        }
+    default: // c.beqz, c.bnez
+        immediate = ((instruction >> 4) & 0x100) | // offset[8]
+                    ((instruction >> 7) & 0x18) |  // offset[4:3]
+                    ((instruction << 1) & 0xc0) |  // offset[7:6]
+                    ((instruction >> 2) & 0x6) |   // offset[2:1]
+                    ((instruction << 3) & 0x20);   // offset[5]
+        return encodeB(signExtend(immediate, 9), ZERO, rdPrime,
+                       (funct3 == 0b110) ? 0b000 : 0b001);
+    }
+}
+
+uint32_t CompressedDecoder::expandQuadrant2(uint16_t instruction) {
+    uint32_t funct3 = (instruction >> 13) & 0b111;
+    uint32_t rd = (instruction >> 7) & 0b11111; // rd / rs1
+    uint32_t rs2 = (instruction >> 2) & 0b11111;
+    bool bit12 = instruction & 0x1000;
+    uint32_t immediate;
+
+    switch (funct3) {
+    case 0b000: // c.slli
+        if (bit12) {
+            return 0; // shamt[5] must be zero on RV32
+        }
+        return encodeI(rs2, rd, 0b001, rd, ITYPE);
+    case 0b010: // c.lwsp
+    case 0b011: // c.flwsp
+        if (funct3 == 0b010 && rd == ZERO) {
+            return 0;
+        }
+        immediate = ((instruction >> 7) & 0x20) | // uimm[5]
+                    ((instruction >> 2) & 0x1c) | // uimm[4:2]
+                    ((instruction << 4) & 0xc0);  // uimm[7:6]
+        return encodeI(immediate, SP, 0b010, rd,
+                       (funct3 == 0b010) ? LOAD : LOAD_FP);
+    case 0b100:
+        if (!bit12) {
+            if (rs2 == ZERO) { // c.jr
+                return rd ? encodeI(0, rd, 0b000, ZERO, JALR) : 0;
+            }
+            // c.mv
+            return encodeR(0, rs2, ZERO, 0b000, rd, RTYPE);
+        }
+        if (rs2 == ZERO) {
+            if (rd == ZERO) { // c.ebreak
+                return encodeI(1, ZERO, 0b000, ZERO, PRIV);
+            }
+            // c.jalr
+            return encodeI(0, rd, 0b000, RA, JALR);
+        }
+        // c.add
+        return encodeR(0, rs2, rd, 0b000, rd, RTYPE);
+    case 0b110: // c.swsp
+    case 0b111: // c.fswsp
+        immediate = ((instruction >> 7) & 0x3c) | // uimm[5:2]
+                    ((instruction >> 1) & 0xc0);  // uimm[7:6]
+        return encodeS(immediate, rs2, SP, 0b010,
+                       (funct3 == 0b110) ? STORE : STORE_FP);
+    default: // Double precision loads/stores
+        return 0;
+    }
+}
+
+uint32_t CompressedDecoder::encodeR(uint32_t funct7, uint32_t rs2,
+                                    uint32_t rs1, uint32_t funct3,
+                                    uint32_t rd, uint32_t opcode) {
+    return (funct7 << 25) | (rs2 << 20) | (rs1 << 15) | (funct3 << 12) |
+           (rd << 7) | opcode;
+}
+
+uint32_t CompressedDecoder::encodeI(uint32_t immediate, uint32_t rs1,
+                                    uint32_t funct3, uint32_t rd,
+                                    uint32_t opcode) {
+    return ((immediate & 0xfff) << 20) | (rs1 << 15) | (funct3 << 12) |
+           (rd << 7) | opcode;
+}
+
+uint32_t CompressedDecoder::encodeS(uint32_t immediate, uint32_t rs2,
+                                    uint32_t rs1, uint32_t funct3,
+                                    uint32_t opcode) {
+    return (((immediate >> 5) & 0x7f) << 25) | (rs2 << 20) | (rs1 << 15) |
+           (funct3 << 12) | ((immediate & 0x1f) << 7) | opcode;
+}
+
+uint32_t CompressedDecoder::encodeB(uint32_t immediate, uint32_t rs2,
+                                    uint32_t rs1, uint32_t funct3) {
+    return (((immediate >> 12) & 0x1) << 31) |  // imm[12]
+           (((immediate >> 5) & 0x3f) << 25) |  // imm[10:5]
+           (rs2 << 20) | (rs1 << 15) | (funct3 << 12) |
+           (((immediate >> 1) & 0xf) << 8) |    // imm[4:1]
+           (((immediate >> 11) & 0x1) << 7) |   // imm[11]
+           BTYPE;
+}
+
+uint32_t CompressedDecoder::encodeJ(uint32_t immediate, uint32_t rd) {
+    return (((immediate >> 20) & 0x1) << 31) |  // imm[20]
+           (((immediate >> 1) & 0x3ff) << 21) | // imm[10:1]
+           (((immediate >> 11) & 0x1) << 20) |  // imm[11]
+           (((immediate >> 12) & 0xff) << 12) | // imm[19:12]
+           (rd << 7) | JAL;
+}
@@ -40,6 +40,34 @@ Csr::Csr() {
 
     // Machine Trap Value
     registers[CSR_MTVAL] = 0;
+
+    // Floating-Point Control and Status (holds fflags and frm)
+    registers[CSR_FCSR] = 0;
+
+    // Machine Trap Delegation
+    registers[CSR_MEDELEG] = 0;
+    registers[CSR_MIDELEG] = 0;
+
+    // Supervisor Trap Setup/Handling (sstatus, sie and sip are views of
+    // the machine registers)
+    registers[CSR_STVEC] = 0;
+    registers[CSR_SSCRATCH] = 0;
+    registers[CSR_SEPC] = 0;
+    registers[CSR_SCAUSE] = 0;
+    registers[CSR_STVAL] = 0;
+
+    // Supervisor Address Translation and Protection (Bare)
+    registers[CSR_SATP] = 0;
+
+    // Physical Memory Protection (all entries off)
+    for (uint32_t i = 0; i < PMP_CFG_REGISTERS; i++) {
+        registers[CSR_PMPCFG0 + i] = 0;
+    }
+    for (uint32_t i = 0; i < PMP_ENTRIES; i++) {
+        registers[CSR_PMPADDR0 + i] = 0;
+    }
+
+    privilegeLevel = MACHINE_MODE;
 }
 
 Csr::~Csr() {
@@ -47,11 +75,64 @@ Csr::~Csr() {
 }
 
 uint32_t Csr::readCsr(uint32_t address) {
-    return registers[address];
+    switch (address) {
+    case CSR_FFLAGS:
+        return registers[CSR_FCSR] & FCSR_FFLAGS_MASK;
+    case CSR_FRM:
+        return (registers[CSR_FCSR] >> FCSR_FRM_MASK) & 0b111;
+    case CSR_SSTATUS:
+        return registers[CSR_MSTATUS] & SSTATUS_MASK;
+    case CSR_SIE:
+        return registers[CSR_MIE] & registers[CSR_MIDELEG];
+    case CSR_SIP:
+        return registers[CSR_MIP] & registers[CSR_MIDELEG];
+    default:
+        return registers[address];
+    }
 }
 
 void Csr::writeCsr(uint32_t address, uint32_t data) {
-    registers[address] = data;
+    uint32_t &fcsr = registers[CSR_FCSR];
+    uint32_t mask;
+
+    switch (address) {
+    case CSR_FFLAGS:
+        fcsr = (fcsr & ~FCSR_FFLAGS_MASK) | (data & FCSR_FFLAGS_MASK);
+        break;
+    case CSR_FRM:
+        fcsr = (fcsr & ~(0b111 << FCSR_FRM_MASK)) |
+               ((data & 0b111) << FCSR_FRM_MASK);
+        break;
+    case CSR_FCSR:
+        fcsr = data & FCSR_MASK;
+        break;
+    case CSR_SSTATUS:
+        registers[CSR_MSTATUS] = (registers[CSR_MSTATUS] & ~SSTATUS_MASK) |
+                                 (data & SSTATUS_MASK);
+        break;
+    case CSR_SIE:
+        registers[CSR_MIE] = (registers[CSR_MIE] & ~registers[CSR_MIDELEG]) |
+                             (data & registers[CSR_MIDELEG]);
+        break;
+    case CSR_SIP:
+        // Only the software interrupt can be raised or cleared from S-mode
+        mask = registers[CSR_MIDELEG] & (1 << MIP_SSIP_MASK);
+        registers[CSR_MIP] = (registers[CSR_MIP] & ~mask) | (data & mask);
+        break;
+    case CSR_MEDELEG:
+        registers[CSR_MEDELEG] = data & MEDELEG_MASK;
+        break;
+    case CSR_MIDELEG:
+        registers[CSR_MIDELEG] = data & MIDELEG_MASK;
+        break;
+    default:
+        if (isPmpCsr(address)) {
+            writePmp(address, data);
+            break;
+        }
+        registers[address] = data;
+        break;
+    }
 }
 
 void Csr::setMie() {
@@ -153,3 +234,113 @@ uint32_t Csr::getMepc() {
 uint32_t Csr::getMtvec() {
     return registers[CSR_MTVEC];
 }
+
+uint32_t Csr::getFrm() {
+    return (registers[CSR_FCSR] >> FCSR_FRM_MASK) & 0b111;
+}
+
+void Csr::accrueFflags(uint32_t fflags) {
+    registers[CSR_FCSR] |= fflags & FCSR_FFLAGS_MASK;
+}
+
+void Csr::setSie() {
+    registers[CSR_MSTATUS] |= (1 << MSTATUS_SIE_MASK);
+}
+
+void Csr::setSpie() {
+    registers[CSR_MSTATUS] |= (1 << MSTATUS_SPIE_MASK);
+}
+
+void Csr::setSpp(int mask) {
+    registers[CSR_MSTATUS] |= ((mask & 0b1) << MSTATUS_SPP_MASK);
+}
+
+void Csr::resetSie() {
+    registers[CSR_MSTATUS] &= ~(1 << MSTATUS_SIE_MASK);
+}
+
+void Csr::resetSpie() {
+    registers[CSR_MSTATUS] &= ~(1 << MSTATUS_SPIE_MASK);
+}
+
+void Csr::resetSpp() {
+    registers[CSR_MSTATUS] &= ~(1 << MSTATUS_SPP_MASK);
+}
+
+void Csr::resetMprv() {
+    registers[CSR_MSTATUS] &= ~(1 << MSTATUS_MPRV_MASK);
+}
+
+uint32_t Csr::getSie() {
+    return ((registers[CSR_MSTATUS] >> MSTATUS_SIE_MASK) & 0b1);
+}
+
+uint32_t Csr::getSpie() {
+    return ((registers[CSR_MSTATUS] >> MSTATUS_SPIE_MASK) & 0b1);
+}
+
+uint32_t Csr::getSpp() {
+    return ((registers[CSR_MSTATUS] >> MSTATUS_SPP_MASK) & 0b1);
+}
+
+uint32_t Csr::getPrivilegeLevel() {
+    return privilegeLevel;
+}
+
+void Csr::setPrivilegeLevel(uint32_t privilegeLevel) {
+    this->privilegeLevel = privilegeLevel;
+}
+
+std::unordered_map<uint32_t, uint32_t> &Csr::getRegisters() {
+    return registers;
+}
+
+bool Csr::isAccessible(uint32_t address, bool isWrite) {
+    if (((address >> 8) & 0b11) > privilegeLevel) {
+        return false;
+    }
+
+    return !(isWrite && ((address >> 10) & 0b11) == 0b11);
+}
+
+uint32_t Csr::getPmpcfg(uint32_t entry) {
+    return (registers[CSR_PMPCFG0 + entry / 4] >> (8 * (entry % 4))) & 0xff;
+}
+
+bool Csr::isPmpCsr(uint32_t address) {
+    return (address >= CSR_PMPCFG0 &&
+            address < CSR_PMPCFG0 + PMP_CFG_REGISTERS) ||
+           (address >= CSR_PMPADDR0 && address < CSR_PMPADDR0 + PMP_ENTRIES);
+}
+
+void Csr::writePmp(uint32_t address, uint32_t data) {
+    if (address >= CSR_PMPADDR0) {
+        uint32_t entry = address - CSR_PMPADDR0;
+        // Locked entries, and the base address of a locked TOR entry, are
+        // read-only
+        bool isNextLockedTor = (entry + 1 < PMP_ENTRIES) &&
+            (getPmpcfg(entry + 1) & PMP_L) &&
+            (((getPmpcfg(entry + 1) >> PMP_A_MASK) & 0b11) == PMP_A_TOR);
+        if (!(getPmpcfg(entry) & PMP_L) && !isNextLockedTor) {
+            registers[address] = data;
+        }
+        return;
+    }
+
+    uint32_t value = registers[address];
+    for (uint32_t i = 0; i < 4; i++) {
+        uint32_t shift = 8 * i;
+        if ((value >> shift) & PMP_L) {
+            continue;
+        }
+
+        // W without R is reserved, W reads back as 0
+        uint32_t cfg = (data >> shift) & (PMP_L | (0b11 << PMP_A_MASK) |
+                                          PMP_X | PMP_W | PMP_R);
+        if ((cfg & PMP_W) && !(cfg & PMP_R)) {
+            cfg &= ~PMP_W;
+        }
+        value = (value & ~(0xff << shift)) | (cfg << shift);
+    }
+    registers[address] = value;
+}
@@ -0,0 +1,193 @@
+#include "Debugger.h"
+
+Debugger::Debugger(const char *elfPath) : elfPath(elfPath), elfStat() {
+    stat(elfPath, &elfStat);
+    dwarfParser = new DwarfParser(elfPath);
+    machine = new Machine(dwarfParser, 1);
+    mcu = machine->getMcu();
+    inputLog = new InputLog(mcu);
+
+    latestSourceLine = dwarfParser->getLineNumberAtPc(
+        mcu->getProgramCounterModule()->getPc());
+}
+
+Debugger::~Debugger() {
+    delete inputLog;
+    delete machine;
+    delete dwarfParser;
+}
+
+void Debugger::executeInstructions(uint cycles) {
+    ProgramCounter *pcModule = mcu->getProgramCounterModule();
+    SemihostMemoryDevice *semihost = mcu->getSemihostDevice();
+
+    // Firmware that exited through semihosting stays stopped
+    for (; cycles && !isBreakpoint(pcModule->getPc()) &&
+           !semihost->hasExited(); cycles--) {
+        mcu->nextInstruction();
+    }
+
+    // if (isBreakpoint(pcModule->getPc())) {
+
+    // }
+}
+
+void Debugger::stepInstruction() {
+    mcu->nextInstruction();
+    
+    // If new line reached, update latestSourceLine
+    uint curLine = dwarfParser->getLineNumberAtPc(
+        mcu->getProgramCounterModule()->getPc());
+    latestSourceLine = curLine ? curLine : latestSourceLine;
+}
+
+void Debugger::stepLine() {
+    uint startPc = mcu->getProgramCounterModule()->getPc();
+    uint curPc, curLine;
+
+    // Keep executing instructions until current line changes
+    // Or if pc repeats when stepping through a for loop
+    do {
+        mcu->nextInstruction();
+        curPc = mcu->getProgramCounterModule()->getPc();
+        curLine = dwarfParser->getLineNumberAtPc(curPc);
+    } while ((curLine == 0 || curLine == latestSourceLine) && startPc != curPc);
+
+    latestSourceLine = curLine;
+}
+
+void Debugger::markLoaded() {
+    machine->markLoaded();
+}
+
+void Debugger::reset() {
+    machine->reset();
+
+    // Recording continues from a cycle count that restarted, start over
+    delete inputLog;
+    inputLog = new InputLog(mcu);
+
+    latestSourceLine = dwarfParser->getLineNumberAtPc(
+        mcu->getProgramCounterModule()->getPc());
+}
+
+bool Debugger::reload() {
+    struct stat newStat;
+    if (stat(elfPath.c_str(), &newStat)) {
+        return false;
+    }
+
+    bool isChanged = newStat.st_size != elfStat.st_size ||
+                     newStat.st_mtim.tv_sec != elfStat.st_mtim.tv_sec ||
+                     newStat.st_mtim.tv_nsec != elfStat.st_mtim.tv_nsec;
+    if (isChanged) {
+        // A build may still be writing the file, check it before parsing
+        ElfParser *elfParser = ElfParser::open(elfPath.c_str());
+        bool isLoadable = elfParser && elfParser->isDebuggable();
+        delete elfParser;
+        if (!isLoadable) {
+            return false;
+        }
+
+        DwarfParser *newDwarfParser = new DwarfParser(elfPath.c_str());
+        if (!machine->load(newDwarfParser)) {
+            delete newDwarfParser;
+            return false;
+        }
+        delete dwarfParser;
+        dwarfParser = newDwarfParser;
+        elfStat = newStat;
+    }
+
+    reset();
+    return true;
+}
+
+void Debugger::addBreakpoint(uint32_t address) {
+    if (std::find(breakpoints.begin(), breakpoints.end(), address) ==
+        breakpoints.end()) {  // Breakpoint at address not found, add it
+        breakpoints.push_back(address);
+    }
+}
+
+void Debugger::removeBreakpoint(uint32_t address) {
+    for (size_t i = 0; i < breakpoints.size(); i++) {
+        if (address == breakpoints[i]) {
+            breakpoints.erase(breakpoints.begin() + i);
+            break;
+        }
+    }
+}
+
+bool Debugger::isBreakpoint(uint32_t address) {
+    return std::find(breakpoints.begin(), breakpoints.end(), address) !=
+           breakpoints.end();
+}
+
+ClintMemoryDevice *Debugger::getClintDevice() { return mcu->getClintDevice(); }
+
+RamMemoryDevice *Debugger::getRamDevice() { return mcu->getRamDevice(); }
+
+RomMemoryDevice *Debugger::getRomDevice() { return mcu->getRomDevice(); }
+
+VideoMemoryDevice *Debugger::getVideoDevice() { return mcu->getVideoDevice(); }
+
+VirtioBlockMemoryDevice *Debugger::getVirtioBlockDevice() {
+    return mcu->getVirtioBlockDevice();
+}
+
+KeyboardMemoryDevice *Debugger::getKeyboardDevice() {
+    return mcu->getKeyboardDevice();
+}
+
+RegisterFile *Debugger::getRegisterFileModule() {
+    return mcu->getRegisterFileModule();
+}
+
+ProgramCounter *Debugger::getProgramCounterModule() {
+    return mcu->getProgramCounterModule();
+}
+
+Csr *Debugger::getCsrModule() { return mcu->getCsrModule(); }
+
+ImmediateGenerator *Debugger::getImmediateGeneratorModule() {
+    return mcu->getImmediateGeneratorModule();
+}
+
+Machine *Debugger::getMachine() { return machine; }
+
+InputLog *Debugger::getInputLog() { return inputLog; }
+
+std::vector<DisassembledEntry> &Debugger::getDisassembledCode() {
+    return dwarfParser->getDisassembledCode();
+}
+
+std::vector<SourceInfo *> &Debugger::getSourceInfo() {
+    return dwarfParser->getSourceInfo();
+}
+
+void Debugger::getLocalVariables(std::vector<Variable *> &variables) {
+    ProgramCounter *pcModule = mcu->getProgramCounterModule();
+    dwarfParser->getLocalVariables(variables, pcModule->getPc(),
+                                   latestSourceLine);
+}
+
+void Debugger::getGlobalVariables(std::vector<Variable *> &variables) {
+    ProgramCounter *pcModule = mcu->getProgramCounterModule();
+    dwarfParser->getGlobalVariables(variables, pcModule->getPc(),
+                                    latestSourceLine);
+}
+
+uint Debugger::getLineNumberAtPc() {
+    return latestSourceLine;
+}
+
+const std::string &Debugger::getSourceNameAtPc() {
+    return dwarfParser->getSourceNameAtPc(
+        mcu->getProgramCounterModule()->getPc());
+}
+
+void Debugger::getVarInfo(VarInfo &res, bool doUpdate, Variable *var) {
+    dwarfParser->getVarInfo(res, doUpdate, var, mcu->getRegisterFileModule(),
+                            mcu->getProgramCounterModule()->getPc());
+}
@@ -93,10 +93,15 @@ uint CompileUnit::getLineNumberAtPc(uint32_t pc) {
     return debugLine->getLineNumberAtPc(pc);
 }
 
-std::string &CompileUnit::getSourceNameAtPc(uint32_t pc) {
+const std::string &CompileUnit::getSourceNameAtPc(uint32_t pc) {
     return debugLine->getSourceNameAtPc(pc);
 }
 
+void CompileUnit::getLineCoverage(LineCoverage &coverage,
+        std::function<bool(uint32_t start, uint32_t end)> isExecuted) {
+    debugLine->getLineCoverage(coverage, isExecuted);
+}
+
 void CompileUnit::getLocalVariables(std::vector<Variable *> &variables,
                                     uint32_t pc, uint line) {
     rootScope->getLocalVariables(variables, pc, line);
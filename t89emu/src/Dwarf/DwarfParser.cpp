@@ -120,10 +120,17 @@ uint DwarfParser::getLineNumberAtPc(uint32_t pc) {
     return getCompileUnitAtPc(pc)->getLineNumberAtPc(pc);
 }
 
-std::string &DwarfParser::getSourceNameAtPc(uint32_t pc) {
+const std::string &DwarfParser::getSourceNameAtPc(uint32_t pc) {
     return getCompileUnitAtPc(pc)->getSourceNameAtPc(pc);
 }
 
+void DwarfParser::getLineCoverage(LineCoverage &coverage,
+        std::function<bool(uint32_t start, uint32_t end)> isExecuted) {
+    for (CompileUnit *cu : compileUnits) {
+        cu->getLineCoverage(coverage, isExecuted);
+    }
+}
+
 void DwarfParser::getLocalVariables(std::vector<Variable *> &variables,
                                     uint32_t pc, uint line) {
     getCompileUnitAtPc(pc)->getLocalVariables(variables, pc, line);
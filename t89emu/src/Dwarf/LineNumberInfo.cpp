@@ -81,10 +81,30 @@ uint LineNumberInfo::getLineNumberAtPc(uint32_t pc) {
     return lineEntry ? lineEntry->line : 0;
 }
 
-std::string temp = "";
-std::string &LineNumberInfo::getSourceNameAtPc(uint32_t pc) {
+const std::string &LineNumberInfo::getSourceNameAtPc(uint32_t pc) {
+    // Name of code without line information
+    static const std::string unknownSourceName = "";
+
     LineEntry *lineEntry = getLineEntryAtPc(pc);
-    return lineEntry ? sourceInfo[lineEntry->file]->getName() : temp;
+    return lineEntry ? sourceInfo[lineEntry->file]->getName()
+                     : unknownSourceName;
+}
+
+void LineNumberInfo::getLineCoverage(LineCoverage &coverage,
+        std::function<bool(uint32_t start, uint32_t end)> isExecuted) {
+    // A row covers the addresses up to the next row of its sequence
+    for (size_t row = 0; row + 1 < lineMatrix.size(); row++) {
+        LineEntry *lineEntry = lineMatrix[row];
+        uint32_t end = lineMatrix[row + 1]->address;
+        if (lineEntry->endSequence || end <= lineEntry->address ||
+            lineEntry->file >= sourceInfo.size()) {
+            continue;
+        }
+
+        bool &isHit = coverage[sourceInfo[lineEntry->file]->getPath()]
+                              [lineEntry->line];
+        isHit = isHit || isExecuted(lineEntry->address, end);
+    }
 }
 
 bool LineNumberInfo::containsPath(std::vector<SourceInfo *> &sources,
@@ -146,7 +166,7 @@ void LineNumberInfo::generateLineNumberMatrix() {
             line += infoHeader.lineBase + (adjustedOpcode % infoHeader.lineRange);
             lineMatrix.push_back(new LineEntry(address, line, column, file,
                                                isStmt, prologueEnd,
-                                               epilogueBegin));
+                                               epilogueBegin, endSequence));
             basicBlock = prologueEnd = epilogueBegin = false;
             discriminator = 0;
         } else if (opcode && opcode < infoHeader.opcodeBase) { // Standard
@@ -154,7 +174,8 @@ void LineNumberInfo::generateLineNumberMatrix() {
             case DW_LNS_copy:
                 lineMatrix.push_back(new LineEntry(address, line, column, file,
                                                    isStmt, prologueEnd,
-                                                   epilogueBegin));
+                                                   epilogueBegin,
+                                                   endSequence));
                 discriminator = 0;
                 basicBlock = prologueEnd = epilogueBegin = false;
                 break;
@@ -202,7 +223,8 @@ void LineNumberInfo::generateLineNumberMatrix() {
                 endSequence = true;
                 lineMatrix.push_back(new LineEntry(address, line, column, file,
                                                    isStmt, prologueEnd,
-                                                   epilogueBegin));
+                                                   epilogueBegin,
+                                                   endSequence));
                 clearRegisters();
                 break;
 
@@ -2,6 +2,11 @@
 
 #include "ElfParser.h"
 
+// Bytes of a segment that are flashed, the rest of the segment is zeroed
+static Elf32_Word getFlashSize(const ElfProgramHeader *pHdr) {
+    return (pHdr->memsz < pHdr->filesz) ? pHdr->memsz : pHdr->filesz;
+}
+
 ElfParser::ElfParser(const char *path)
     : ramHeader(nullptr), romHeader(nullptr) {
     elfFileInfo = new ElfFileInformation();
@@ -9,10 +14,26 @@ ElfParser::ElfParser(const char *path)
            "ElfParser.cpp: ELF Initialization Failed\n");
 }
 
+ElfParser::ElfParser() : ramHeader(nullptr), romHeader(nullptr) {
+    elfFileInfo = new ElfFileInformation();
+}
+
 ElfParser::~ElfParser() {
+    free(elfFileInfo->elfData);
     delete elfFileInfo;
 }
 
+ElfParser *ElfParser::open(const char *path) {
+    ElfParser *elfParser = new ElfParser();
+    if (!elfParser->initStructures(path) || !elfParser->romHeader ||
+        !elfParser->ramHeader) {
+        delete elfParser;
+        return nullptr;
+    }
+
+    return elfParser;
+}
+
 // Flash loadable ROM + RAM into ROM Device
 void ElfParser::flashRom(RomMemoryDevice *romDevice) {
     uint8_t *buf = romDevice->getBuffer();
@@ -20,8 +41,7 @@ void ElfParser::flashRom(RomMemoryDevice *romDevice) {
     // Order is important, flash ROM, then RAM
     auto loadableSections = {romHeader, ramHeader};
     for (const ElfProgramHeader *pHdr : loadableSections) {
-        Elf32_Word sectionSize =
-            (pHdr->memsz < pHdr->filesz) ? pHdr->memsz : pHdr->filesz;
+        Elf32_Word sectionSize = getFlashSize(pHdr);
         for (size_t i = 0; i < sectionSize; i++) {
             *(buf++) = *((uint8_t *)(elfFileInfo->elfData + pHdr->offset + i));
         }
@@ -48,6 +68,30 @@ uint32_t ElfParser::getRomStart() {
     return romHeader->paddr;
 }
 
+bool ElfParser::getSymbolAddress(const char *name, uint32_t *address) {
+    const struct ElfSectionHeader *strtabHdr = getSectionHeader(".strtab");
+    const struct ElfSectionHeader *symtabHdr = getSectionHeader(".symtab");
+    if (!strtabHdr || !symtabHdr) {
+        return false;
+    }
+
+    const struct ElfSymbol *sym =
+        (const struct ElfSymbol *)(elfFileInfo->elfData + symtabHdr->offset);
+    const struct ElfSymbol *endSym =
+        (const struct ElfSymbol *)(elfFileInfo->elfData + symtabHdr->offset +
+                                   symtabHdr->size);
+    const char *strtabStr =
+        (const char *)(elfFileInfo->elfData + strtabHdr->offset);
+    for (; sym < endSym; sym++) {
+        if (!strcmp(strtabStr + sym->name, name)) {
+            *address = sym->value;
+            return true;
+        }
+    }
+
+    return false;
+}
+
 bool ElfParser::isDebuggable() {
     return getSectionHeader(".debug_info") != NULL;
 }
@@ -63,7 +107,7 @@ bool ElfParser::initStructures(const char *path) {
     fseek(fp, 0, SEEK_END);
     elfFileInfo->elfSize = ftell(fp);
     fseek(fp, 0, SEEK_SET);
-    if (!elfFileInfo->elfSize) {
+    if (elfFileInfo->elfSize < sizeof(struct ElfHeader)) {
         fclose(fp);
         return false;
     }
@@ -78,7 +122,6 @@ bool ElfParser::initStructures(const char *path) {
     fclose(fp);
 
     if (index != elfFileInfo->elfSize) {
-        free(elfFileInfo);
         return false;
     }
 
@@ -97,6 +140,16 @@ bool ElfParser::initStructures(const char *path) {
         return false;
     }
 
+    // The program header table must lie within the file
+    unsigned int elfSize = elfFileInfo->elfSize;
+    if (elfHeaderInfo->phentsize < sizeof(struct ElfProgramHeader) ||
+        elfHeaderInfo->phoff > elfSize ||
+        (uint64_t)elfHeaderInfo->phnum * elfHeaderInfo->phentsize >
+            elfSize - elfHeaderInfo->phoff) {
+        std::cerr << "Error: " << path << " has no valid program headers\n";
+        return false;
+    }
+
     // Locate ROM/RAM program section headers
     for (int idx = 0; idx < elfHeaderInfo->phnum; idx++) {
         const struct ElfProgramHeader *pHdr = getProgramHeader(idx);
@@ -106,16 +159,36 @@ bool ElfParser::initStructures(const char *path) {
             continue;
         }
 
+        if (pHdr->offset > elfSize || pHdr->filesz > elfSize - pHdr->offset) {
+            std::cerr << "Error: " << path << " has a segment outside of "
+                      << "the file\n";
+            return false;
+        }
+
         // Check if section is ROM/RAM
         if ((pHdr->flags & PF_R) && (pHdr->flags & PF_W)) {
-            ASSERT(!ramHeader, "ElfParser.cpp: duplicate RAM section.");
+            if (ramHeader) {
+                std::cerr << "Error: " << path << " has two RAM segments\n";
+                return false;
+            }
             ramHeader = pHdr;
-        } else if ((pHdr->flags & PF_R) && (pHdr->flags & PF_X) && !romHeader) {
-            ASSERT(!romHeader, "ElfParser.cpp: duplicate ROM section.");
+        } else if ((pHdr->flags & PF_R) && (pHdr->flags & PF_X)) {
+            if (romHeader) {
+                std::cerr << "Error: " << path << " has two ROM segments\n";
+                return false;
+            }
             romHeader = pHdr;
         }
     }
 
+    // Both segments are flashed into the ROM device
+    if (romHeader && ramHeader &&
+        (uint64_t)getFlashSize(romHeader) + getFlashSize(ramHeader) >
+            ROM_SIZE) {
+        std::cerr << "Error: " << path << " does not fit in ROM\n";
+        return false;
+    }
+
     return true;
 }
 
@@ -179,8 +252,11 @@ bool ElfParser::generateDisassembledCode() {
         // Starting address of program section
         Elf32_Addr address_start = section->paddr;
 
-        // Add current executable section to text
-        for (Elf32_Addr idx = 0; idx < section_size; idx += 4) {
+        // Add current executable section to text, compressed instructions
+        // are 2 bytes long
+        Elf32_Addr instructionLength;
+        for (Elf32_Addr idx = 0; idx + 2 <= section_size;
+             idx += instructionLength) {
             Elf32_Addr curAddr = address_start + idx;
             // Used for Disassembler in GUI
             struct DisassembledEntry disassembledLine;
@@ -197,7 +273,16 @@ bool ElfParser::generateDisassembledCode() {
             }
 
             Elf32_Word instruction =
-                *((uint32_t *)(elfFileInfo->elfData + section->offset + idx));
+                *((uint16_t *)(elfFileInfo->elfData + section->offset + idx));
+            instructionLength = 2;
+            if (!CompressedDecoder::isCompressed(instruction)) {
+                if (idx + 4 > section_size) {
+                    break;
+                }
+                instruction = *((uint32_t *)(elfFileInfo->elfData +
+                                             section->offset + idx));
+                instructionLength = 4;
+            }
             disassembledLine.isInstruction = true;
             disassembledLine.address = curAddr;
             disassembledLine.instruction = instruction;
@@ -258,6 +343,11 @@ std::string ElfParser::generateInstructionStr(struct DisassembledEntry &entry) {
         "zero", "ra", "sp", "gp", "tp",  "t0",  "t1", "t2", "s0", "s1", "a0",
         "a1",   "a2", "a3", "a4", "a5",  "a6",  "a7", "s2", "s3", "s4", "s5",
         "s6",   "s7", "s8", "s9", "s10", "s11", "t3", "t4", "t5", "t6"};
+    const std::vector<std::string> floatRegisterNames = {
+        "ft0", "ft1", "ft2",  "ft3",  "ft4", "ft5", "ft6",  "ft7",
+        "fs0", "fs1", "fa0",  "fa1",  "fa2", "fa3", "fa4",  "fa5",
+        "fa6", "fa7", "fs2",  "fs3",  "fs4", "fs5", "fs6",  "fs7",
+        "fs8", "fs9", "fs10", "fs11", "ft8", "ft9", "ft10", "ft11"};
 
     const std::vector<std::string> branchInstructions = {
         "beq", "bne", "nan", "nan", "blt", "bge", "bltu", "bgeu"};
@@ -269,11 +359,33 @@ std::string ElfParser::generateInstructionStr(struct DisassembledEntry &entry) {
     const std::vector<std::string> srliSrai = {"srli", "srai"};
     const std::vector<std::string> rInstructions = {"nan", "sll", "slt", "sltu",
                                                     "xor", "nan", "or",  "and"};
+    const std::vector<std::string> mInstructions = {
+        "mul", "mulh", "mulhsu", "mulhu", "div", "divu", "rem", "remu"};
     const std::vector<std::string> csrInstructions = {"nan", "csrrw", "csrrs",
                                                       "csrrc"};
 
     uint32_t instruction = entry.instruction;
     uint32_t addr = entry.address;
+
+    // Compressed instructions are shown as the instruction they expand to
+    if (CompressedDecoder::isCompressed(instruction)) {
+        CompressedDecoder decoder;
+        struct DisassembledEntry expanded = entry;
+        expanded.instruction = decoder.expand(instruction);
+        if (expanded.instruction == 0) {
+            char compressedStr[16];
+            sprintf(compressedStr, "%04x", instruction);
+            return compressedStr;
+        }
+
+        // Prefix the mnemonic with "c.", keeping operands aligned
+        std::string expandedStr = generateInstructionStr(expanded);
+        size_t mnemonicEnd = expandedStr.find(' ');
+        if (mnemonicEnd != std::string::npos && mnemonicEnd <= 5) {
+            expandedStr.erase(mnemonicEnd, 2);
+        }
+        return "c." + expandedStr;
+    }
     ImmediateGenerator *immgen = new ImmediateGenerator();
 
     int opcode = instruction & 0x7f;
@@ -286,6 +398,11 @@ std::string ElfParser::generateInstructionStr(struct DisassembledEntry &entry) {
     uint32_t csrAddr = (instruction >> 20) & 0xfff;
 
     char instructionStr[64];
+    std::string amoName;
+    std::string bitManipName;
+    std::string floatName;
+    std::string floatRd;
+    std::string floatRs1;
     switch (opcode) {
     case LUI:
         immediate = (immediate >> 12) & 0xfffff;
@@ -325,6 +442,20 @@ std::string ElfParser::generateInstructionStr(struct DisassembledEntry &entry) {
                 registerNames.at(rs1).c_str());
         break;
     case ITYPE:
+        bitManipName = getBitManipName(instruction);
+        if (!bitManipName.empty()) {
+            if (funct3 == 0b101 && funct7 == 0b0110000) { // rori
+                sprintf(instructionStr, "%-8s%s,%s,0x%x",
+                        bitManipName.c_str(), registerNames.at(rd).c_str(),
+                        registerNames.at(rs1).c_str(), rs2);
+            } else { // Single operand
+                sprintf(instructionStr, "%-8s%s,%s", bitManipName.c_str(),
+                        registerNames.at(rd).c_str(),
+                        registerNames.at(rs1).c_str());
+            }
+            break;
+        }
+
         switch(funct3) {
         case 0b101:	// srai / srli
             switch(funct7) {
@@ -354,6 +485,29 @@ std::string ElfParser::generateInstructionStr(struct DisassembledEntry &entry) {
         }
         break;
     case RTYPE:
+        bitManipName = getBitManipName(instruction);
+        if (bitManipName == "zext.h") {
+            sprintf(instructionStr, "%-8s%s,%s", bitManipName.c_str(),
+                    registerNames.at(rd).c_str(),
+                    registerNames.at(rs1).c_str());
+            break;
+        } else if (!bitManipName.empty()) {
+            sprintf(instructionStr, "%-8s%s,%s,%s", bitManipName.c_str(),
+                    registerNames.at(rd).c_str(),
+                    registerNames.at(rs1).c_str(),
+                    registerNames.at(rs2).c_str());
+            break;
+        }
+
+        if (funct7 == MULDIV_FUNCT7) {
+            sprintf(instructionStr, "%-8s%s,%s,%s",
+                    mInstructions.at(funct3).c_str(),
+                    registerNames.at(rd).c_str(),
+                    registerNames.at(rs1).c_str(),
+                    registerNames.at(rs2).c_str());
+            break;
+        }
+
         switch(funct3) {
         case 0b000: // add / sub
             switch(funct7) {
@@ -396,16 +550,101 @@ std::string ElfParser::generateInstructionStr(struct DisassembledEntry &entry) {
             break;
         }
         break;
+    case AMO:
+        amoName = getAmoName(funct7 >> 2);
+        amoName += (funct7 & 0b10) ? ".aq" : "";
+        amoName += (funct7 & 0b01) ? ".rl" : "";
+        if ((funct7 >> 2) == AMO_LR) {
+            sprintf(instructionStr, "%-8s%s,(%s)", amoName.c_str(),
+                    registerNames.at(rd).c_str(),
+                    registerNames.at(rs1).c_str());
+        } else {
+            sprintf(instructionStr, "%-8s%s,%s,(%s)", amoName.c_str(),
+                    registerNames.at(rd).c_str(),
+                    registerNames.at(rs2).c_str(),
+                    registerNames.at(rs1).c_str());
+        }
+        break;
+    case LOAD_FP:
+        sprintf(instructionStr, "%-8s%s,%d(%s)", "flw",
+                floatRegisterNames.at(rd).c_str(), immediate,
+                registerNames.at(rs1).c_str());
+        break;
+    case STORE_FP:
+        sprintf(instructionStr, "%-8s%s,%d(%s)", "fsw",
+                floatRegisterNames.at(rs2).c_str(), immediate,
+                registerNames.at(rs1).c_str());
+        break;
+    case FMADD:
+    case FMSUB:
+    case FNMSUB:
+    case FNMADD:
+        floatName = getFloatName(instruction);
+        if (floatName.size() >= 8) {
+            floatName += " "; // fnmadd.s / fnmsub.s fill the column
+        }
+        sprintf(instructionStr, "%-8s%s,%s,%s,%s", floatName.c_str(),
+                floatRegisterNames.at(rd).c_str(),
+                floatRegisterNames.at(rs1).c_str(),
+                floatRegisterNames.at(rs2).c_str(),
+                floatRegisterNames.at(instruction >> 27).c_str());
+        break;
+    case OP_FP:
+        // Keep a space after mnemonics that fill the column (fclass.s)
+        floatName = getFloatName(instruction);
+        if (floatName.size() >= 8) {
+            floatName += " ";
+        }
+        floatRd = FloatingPointUnit::isIntegerDestination(instruction)
+                      ? registerNames.at(rd)
+                      : floatRegisterNames.at(rd);
+        floatRs1 = FloatingPointUnit::isIntegerSource(instruction)
+                       ? registerNames.at(rs1)
+                       : floatRegisterNames.at(rs1);
+        switch (funct7) {
+        case 0b0101100: // fsqrt.s
+        case 0b1100000: // fcvt.w[u].s
+        case 0b1101000: // fcvt.s.w[u]
+        case 0b1110000: // fmv.x.w / fclass.s
+        case 0b1111000: // fmv.w.x
+            sprintf(instructionStr, "%-8s%s,%s", floatName.c_str(),
+                    floatRd.c_str(), floatRs1.c_str());
+            break;
+        default:
+            sprintf(instructionStr, "%-8s%s,%s,%s", floatName.c_str(),
+                    floatRd.c_str(), floatRs1.c_str(),
+                    floatRegisterNames.at(rs2).c_str());
+            break;
+        }
+        break;
+    case FENCE:
+        sprintf(instructionStr, (funct3 == 0b001) ? "fence.i" : "fence");
+        break;
     case PRIV:
         switch (funct3) {
-        case 0b000: // ECALL / MRET
+        case 0b000: // ECALL / MRET / SRET / SFENCE.VMA
+            if ((immediate >> 5) == SFENCE_VMA_FUNCT7) {
+                sprintf(instructionStr, "%-8s%s,%s", "sfence.vma",
+                        registerNames.at(rs1).c_str(),
+                        registerNames.at(rs2).c_str());
+                break;
+            }
             switch (immediate) {
             case MRET_IMM:
                 sprintf(instructionStr, "mret");
                 break;
+            case SRET_IMM:
+                sprintf(instructionStr, "sret");
+                break;
             case ECALL_IMM:
                 sprintf(instructionStr, "ecall");
                 break;
+            case WFI_IMM:
+                sprintf(instructionStr, "wfi");
+                break;
+            default:
+                sprintf(instructionStr, "%08x", instruction);
+                break;
             }
             break;
         default: // CSRRW / CSRRS / CSRRC
@@ -425,10 +664,134 @@ std::string ElfParser::generateInstructionStr(struct DisassembledEntry &entry) {
     return instructionStr;
 }
 
+// Zba/Zbb mnemonic of an OP or OP-IMM instruction, empty if it is not one
+std::string ElfParser::getBitManipName(uint32_t instruction) {
+    uint32_t opcode = instruction & 0x7f;
+    uint32_t funct3 = (instruction >> 12) & 0b111;
+    uint32_t funct7 = (instruction >> 25) & 0b1111111;
+    uint32_t rs2 = (instruction >> 20) & 0b11111;
+
+    if (opcode == ITYPE) {
+        if (funct3 == 0b001 && funct7 == 0b0110000) {
+            switch (rs2) {
+            case 0b00000: return "clz";
+            case 0b00001: return "ctz";
+            case 0b00010: return "cpop";
+            case 0b00100: return "sext.b";
+            case 0b00101: return "sext.h";
+            }
+        } else if (funct3 == 0b101) {
+            switch (funct7) {
+            case 0b0110000: return "rori";
+            case 0b0110100: return "rev8";
+            case 0b0010100: return "orc.b";
+            }
+        }
+        return "";
+    }
+
+    switch ((funct7 << 3) | funct3) {
+    case (0b0010000 << 3) | 0b010: return "sh1add";
+    case (0b0010000 << 3) | 0b100: return "sh2add";
+    case (0b0010000 << 3) | 0b110: return "sh3add";
+    case (0b0100000 << 3) | 0b111: return "andn";
+    case (0b0100000 << 3) | 0b110: return "orn";
+    case (0b0100000 << 3) | 0b100: return "xnor";
+    case (0b0000101 << 3) | 0b100: return "min";
+    case (0b0000101 << 3) | 0b101: return "minu";
+    case (0b0000101 << 3) | 0b110: return "max";
+    case (0b0000101 << 3) | 0b111: return "maxu";
+    case (0b0110000 << 3) | 0b001: return "rol";
+    case (0b0110000 << 3) | 0b101: return "ror";
+    case (0b0000100 << 3) | 0b100: return "zext.h";
+    default: return "";
+    }
+}
+
+std::string ElfParser::getAmoName(uint32_t funct5) {
+    switch (funct5) {
+    case AMO_LR: return "lr.w";
+    case AMO_SC: return "sc.w";
+    case AMO_ADD: return "amoadd.w";
+    case AMO_SWAP: return "amoswap.w";
+    case AMO_XOR: return "amoxor.w";
+    case AMO_OR: return "amoor.w";
+    case AMO_AND: return "amoand.w";
+    case AMO_MIN: return "amomin.w";
+    case AMO_MAX: return "amomax.w";
+    case AMO_MINU: return "amominu.w";
+    case AMO_MAXU: return "amomaxu.w";
+    default: return "amo_unkwn";
+    }
+}
+
+// RV32F mnemonic of a fused multiply-add or OP-FP instruction
+std::string ElfParser::getFloatName(uint32_t instruction) {
+    uint32_t opcode = instruction & 0x7f;
+    uint32_t funct3 = (instruction >> 12) & 0b111;
+    uint32_t funct7 = (instruction >> 25) & 0b1111111;
+    uint32_t rs2 = (instruction >> 20) & 0b11111;
+
+    switch (opcode) {
+    case FMADD: return "fmadd.s";
+    case FMSUB: return "fmsub.s";
+    case FNMSUB: return "fnmsub.s";
+    case FNMADD: return "fnmadd.s";
+    }
+
+    switch (funct7) {
+    case 0b0000000: return "fadd.s";
+    case 0b0000100: return "fsub.s";
+    case 0b0001000: return "fmul.s";
+    case 0b0001100: return "fdiv.s";
+    case 0b0101100: return "fsqrt.s";
+    case 0b0010000:
+        switch (funct3) {
+        case 0b000: return "fsgnj.s";
+        case 0b001: return "fsgnjn.s";
+        case 0b010: return "fsgnjx.s";
+        }
+        break;
+    case 0b0010100: return (funct3 == 0b000) ? "fmin.s" : "fmax.s";
+    case 0b1010000:
+        switch (funct3) {
+        case 0b000: return "fle.s";
+        case 0b001: return "flt.s";
+        case 0b010: return "feq.s";
+        }
+        break;
+    case 0b1100000: return (rs2 == 0) ? "fcvt.w.s" : "fcvt.wu.s";
+    case 0b1101000: return (rs2 == 0) ? "fcvt.s.w" : "fcvt.s.wu";
+    case 0b1110000: return (funct3 == 0b000) ? "fmv.x.w" : "fclass.s";
+    case 0b1111000: return "fmv.w.x";
+    }
+    return "fp_unkwn";
+}
+
 std::string ElfParser::getCsrName(int csrAddr) {
+    if (csrAddr >= 0x03a0 && csrAddr <= 0x03a3) {
+        return "pmpcfg" + std::to_string(csrAddr - 0x03a0);
+    } else if (csrAddr >= 0x03b0 && csrAddr <= 0x03bf) {
+        return "pmpaddr" + std::to_string(csrAddr - 0x03b0);
+    }
+
     switch (csrAddr) {
+    case 0x0001: return "fflags";
+    case 0x0002: return "frm";
+    case 0x0003: return "fcsr";
+    case 0x0100: return "sstatus";
+    case 0x0104: return "sie";
+    case 0x0105: return "stvec";
+    case 0x0140: return "sscratch";
+    case 0x0141: return "sepc";
+    case 0x0142: return "scause";
+    case 0x0143: return "stval";
+    case 0x0144: return "sip";
+    case 0x0180: return "satp";
     case 0x0300: return "mstatus";
     case 0x0301: return "misa";
+    case 0x0302: return "medeleg";
+    case 0x0303: return "mideleg";
     case 0x0304: return "mie";
     case 0x0305: return "mtvec";
     case 0x0340: return "mscratch";
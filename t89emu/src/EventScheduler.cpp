@@ -0,0 +1,31 @@
+#include "EventScheduler.h"
+
+EventScheduler::EventScheduler()
+    : cycle(0), nextEventCycle(UINT64_MAX), sequence(0) {
+
+}
+
+EventScheduler::~EventScheduler() {
+
+}
+
+void EventScheduler::schedule(uint64_t eventCycle,
+                              std::function<void(void)> callback) {
+    events.push({eventCycle, sequence++, callback});
+    nextEventCycle = events.top().cycle;
+}
+
+void EventScheduler::runEvents() {
+    while (!events.empty() && events.top().cycle <= cycle) {
+        // Callbacks may schedule new events, pop before running
+        std::function<void(void)> callback = events.top().callback;
+        events.pop();
+        callback();
+    }
+
+    nextEventCycle = events.empty() ? UINT64_MAX : events.top().cycle;
+}
+
+uint64_t EventScheduler::getCycle() {
+    return cycle;
+}
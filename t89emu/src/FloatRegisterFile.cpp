@@ -0,0 +1,34 @@
+#include "FloatRegisterFile.h"
+
+/*
+f0-7        ft0-7
+f8-9        fs0-1
+f10-11      fa0-1
+f12-17      fa2-7
+f18-27      fs2-11
+f28-31      ft8-11
+*/
+FloatRegisterFile::FloatRegisterFile() {
+    registers = new uint32_t[32]();
+    names = {"ft0", "ft1", "ft2",  "ft3",  "ft4", "ft5", "ft6",  "ft7",
+             "fs0", "fs1", "fa0",  "fa1",  "fa2", "fa3", "fa4",  "fa5",
+             "fa6", "fa7", "fs2",  "fs3",  "fs4", "fs5", "fs6",  "fs7",
+             "fs8", "fs9", "fs10", "fs11", "ft8", "ft9", "ft10", "ft11"};
+}
+
+FloatRegisterFile::~FloatRegisterFile() {
+    delete[] registers;
+}
+
+uint32_t FloatRegisterFile::read(int reg) {
+    return registers[reg];
+}
+
+void FloatRegisterFile::write(uint32_t data, int reg) {
+    // Unlike x0, f0 is a normal register
+    registers[reg] = data;
+}
+
+std::vector<std::string>& FloatRegisterFile::getNames() {
+    return names;
+}
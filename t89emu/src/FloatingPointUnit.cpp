@@ -0,0 +1,322 @@
+#include "FloatingPointUnit.h"
+
+#include <cfenv>
+#include <cmath>
+#include <cstring>
+
+FloatingPointUnit::FloatingPointUnit() {
+
+}
+
+FloatingPointUnit::~FloatingPointUnit() {
+
+}
+
+uint32_t FloatingPointUnit::execute(uint32_t instruction, uint32_t A,
+                                    uint32_t B, uint32_t C, uint32_t frm,
+                                    uint32_t *result, uint32_t *fflags) {
+    uint32_t opcode = instruction & 0x7f;
+    uint32_t funct3 = (instruction >> 12) & 0b111;
+    uint32_t funct7 = instruction >> 25;
+    uint32_t rs2 = (instruction >> 20) & 0x1f;
+    uint32_t rm = (funct3 == RM_DYN) ? frm : funct3;
+    float a = toFloat(A);
+    float b = toFloat(B);
+    float c = toFloat(C);
+    volatile float value;
+
+    *fflags = 0;
+
+    if (opcode != OP_FP) {
+        // Fused multiply-add, only the single precision format exists
+        if ((funct7 & 0b11) != 0 || rm > RM_RMM) {
+            return ILLEGAL_INSTRUCTION;
+        }
+
+        setHostRounding(rm);
+        switch (opcode) {
+        case FMADD: value = fmaf(a, b, c); break; // (a * b) + c
+        case FMSUB: value = fmaf(a, b, -c); break; // (a * b) - c
+        case FNMSUB: value = fmaf(-a, b, c); break; // -(a * b) + c
+        case FNMADD: value = fmaf(-a, b, -c); break; // -(a * b) - c
+        default: return ILLEGAL_INSTRUCTION;
+        }
+        *fflags = getHostFlags();
+        *result = canonicalize(value);
+        return STATUS_OK;
+    }
+
+    return executeOpFp(funct7, funct3, rs2, a, b, A, B, rm, result, fflags);
+}
+
+uint32_t FloatingPointUnit::executeOpFp(uint32_t funct7, uint32_t funct3,
+                                        uint32_t rs2, float a, float b,
+                                        uint32_t A, uint32_t B, uint32_t rm,
+                                        uint32_t *result, uint32_t *fflags) {
+    volatile float value;
+
+    switch (funct7) {
+    case 0b0000000: // fadd.s
+    case 0b0000100: // fsub.s
+    case 0b0001000: // fmul.s
+    case 0b0001100: // fdiv.s
+    case 0b0101100: // fsqrt.s
+        if (rm > RM_RMM || (funct7 == 0b0101100 && rs2 != 0)) {
+            return ILLEGAL_INSTRUCTION;
+        }
+
+        setHostRounding(rm);
+        switch (funct7) {
+        case 0b0000000: value = a + b; break;
+        case 0b0000100: value = a - b; break;
+        case 0b0001000: value = a * b; break;
+        case 0b0001100: value = a / b; break;
+        default: value = sqrtf(a); break;
+        }
+        *fflags = getHostFlags();
+        *result = canonicalize(value);
+        return STATUS_OK;
+    case 0b0010000: // fsgnj.s, fsgnjn.s, fsgnjx.s
+        switch (funct3) {
+        case 0b000: *result = (A & 0x7fffffff) | (B & 0x80000000); break;
+        case 0b001: *result = (A & 0x7fffffff) | (~B & 0x80000000); break;
+        case 0b010: *result = A ^ (B & 0x80000000); break;
+        default: return ILLEGAL_INSTRUCTION;
+        }
+        return STATUS_OK;
+    case 0b0010100: // fmin.s, fmax.s
+        if (funct3 > 0b001) {
+            return ILLEGAL_INSTRUCTION;
+        }
+        *result = minMax(A, B, funct3 == 0b001, fflags);
+        return STATUS_OK;
+    case 0b1010000: // fle.s, flt.s, feq.s
+        if (funct3 > 0b010) {
+            return ILLEGAL_INSTRUCTION;
+        }
+        *result = compare(A, B, funct3, fflags);
+        return STATUS_OK;
+    case 0b1100000: // fcvt.w.s, fcvt.wu.s
+        if (rm > RM_RMM || rs2 > 1) {
+            return ILLEGAL_INSTRUCTION;
+        }
+        *result = convertToInteger(a, rm, rs2 == 1, fflags);
+        return STATUS_OK;
+    case 0b1101000: // fcvt.s.w, fcvt.s.wu
+        if (rm > RM_RMM || rs2 > 1) {
+            return ILLEGAL_INSTRUCTION;
+        }
+
+        setHostRounding(rm);
+        if (rs2 == 1) {
+            value = (float)A;
+        } else {
+            value = (float)(int32_t)A;
+        }
+        *fflags = getHostFlags();
+        *result = toBits(value);
+        return STATUS_OK;
+    case 0b1110000: // fmv.x.w, fclass.s
+        if (rs2 != 0 || funct3 > 0b001) {
+            return ILLEGAL_INSTRUCTION;
+        }
+        *result = (funct3 == 0b000) ? A : classify(A);
+        return STATUS_OK;
+    case 0b1111000: // fmv.w.x
+        if (rs2 != 0 || funct3 != 0b000) {
+            return ILLEGAL_INSTRUCTION;
+        }
+        *result = A;
+        return STATUS_OK;
+    default:
+        return ILLEGAL_INSTRUCTION;
+    }
+}
+
+bool FloatingPointUnit::isIntegerSource(uint32_t instruction) {
+    uint32_t funct7 = instruction >> 25;
+
+    return (instruction & 0x7f) == OP_FP &&
+           (funct7 == 0b1101000 || funct7 == 0b1111000);
+}
+
+bool FloatingPointUnit::isIntegerDestination(uint32_t instruction) {
+    uint32_t funct7 = instruction >> 25;
+
+    return (instruction & 0x7f) == OP_FP &&
+           (funct7 == 0b1100000 || funct7 == 0b1110000 ||
+            funct7 == 0b1010000);
+}
+
+uint32_t FloatingPointUnit::convertToInteger(float a, uint32_t rm,
+                                             bool isUnsigned,
+                                             uint32_t *fflags) {
+    double value = a;
+    double rounded;
+
+    // NaN converts to the largest integer
+    if (std::isnan(value)) {
+        *fflags = FFLAG_NV;
+        return isUnsigned ? 0xffffffff : 0x7fffffff;
+    }
+
+    switch (rm) {
+    case RM_RTZ: rounded = std::trunc(value); break;
+    case RM_RDN: rounded = std::floor(value); break;
+    case RM_RUP: rounded = std::ceil(value); break;
+    case RM_RMM: rounded = std::round(value); break;
+    default: rounded = std::nearbyint(value); break; // Host is round to nearest
+    }
+
+    // Out of range values saturate and raise invalid instead of inexact
+    if (isUnsigned) {
+        if (rounded < 0.0) {
+            *fflags = FFLAG_NV;
+            return 0;
+        } else if (rounded > 4294967295.0) {
+            *fflags = FFLAG_NV;
+            return 0xffffffff;
+        }
+    } else {
+        if (rounded < -2147483648.0) {
+            *fflags = FFLAG_NV;
+            return 0x80000000;
+        } else if (rounded > 2147483647.0) {
+            *fflags = FFLAG_NV;
+            return 0x7fffffff;
+        }
+    }
+
+    *fflags = (rounded != value) ? FFLAG_NX : 0;
+    return isUnsigned ? (uint32_t)rounded : (uint32_t)(int32_t)rounded;
+}
+
+uint32_t FloatingPointUnit::minMax(uint32_t A, uint32_t B, bool isMax,
+                                   uint32_t *fflags) {
+    float a = toFloat(A);
+    float b = toFloat(B);
+
+    *fflags = (isSignalingNan(A) || isSignalingNan(B)) ? FFLAG_NV : 0;
+
+    // A single NaN operand is ignored
+    if (isNan(A) && isNan(B)) {
+        return CANONICAL_NAN;
+    } else if (isNan(A)) {
+        return B;
+    } else if (isNan(B)) {
+        return A;
+    }
+
+    // -0.0 is treated as less than +0.0
+    if (a == b) {
+        bool isNegativeA = (A >> 31) != 0;
+        return (isNegativeA != isMax) ? A : B;
+    }
+
+    if (isMax) {
+        return (a > b) ? A : B;
+    }
+    return (a < b) ? A : B;
+}
+
+uint32_t FloatingPointUnit::compare(uint32_t A, uint32_t B, uint32_t funct3,
+                                    uint32_t *fflags) {
+    float a = toFloat(A);
+    float b = toFloat(B);
+
+    // feq.s is a quiet comparison, flt.s and fle.s are signaling
+    if (isNan(A) || isNan(B)) {
+        if (funct3 != 0b010 || isSignalingNan(A) || isSignalingNan(B)) {
+            *fflags = FFLAG_NV;
+        }
+        return 0;
+    }
+
+    switch (funct3) {
+    case 0b000: return a <= b; // fle.s
+    case 0b001: return a < b; // flt.s
+    default: return a == b; // feq.s
+    }
+}
+
+/*
+bit     class
+0       -inf
+1       negative normal
+2       negative subnormal
+3       -0
+4       +0
+5       positive subnormal
+6       positive normal
+7       +inf
+8       signaling NaN
+9       quiet NaN
+*/
+uint32_t FloatingPointUnit::classify(uint32_t A) {
+    bool isNegative = (A >> 31) != 0;
+    uint32_t exponent = (A >> 23) & 0xff;
+    uint32_t mantissa = A & 0x7fffff;
+
+    if (exponent == 0xff) {
+        if (mantissa == 0) {
+            return isNegative ? (1 << 0) : (1 << 7);
+        }
+        return isSignalingNan(A) ? (1 << 8) : (1 << 9);
+    } else if (exponent == 0) {
+        if (mantissa == 0) {
+            return isNegative ? (1 << 3) : (1 << 4);
+        }
+        return isNegative ? (1 << 2) : (1 << 5);
+    }
+    return isNegative ? (1 << 1) : (1 << 6);
+}
+
+void FloatingPointUnit::setHostRounding(uint32_t rm) {
+    // The host has no ties-to-max-magnitude mode, RMM rounds to nearest even
+    switch (rm) {
+    case RM_RTZ: fesetround(FE_TOWARDZERO); break;
+    case RM_RDN: fesetround(FE_DOWNWARD); break;
+    case RM_RUP: fesetround(FE_UPWARD); break;
+    default: fesetround(FE_TONEAREST); break;
+    }
+    feclearexcept(FE_ALL_EXCEPT);
+}
+
+uint32_t FloatingPointUnit::getHostFlags() {
+    int exceptions = fetestexcept(FE_ALL_EXCEPT);
+    uint32_t fflags = 0;
+
+    if (exceptions & FE_INEXACT) {fflags |= FFLAG_NX;}
+    if (exceptions & FE_UNDERFLOW) {fflags |= FFLAG_UF;}
+    if (exceptions & FE_OVERFLOW) {fflags |= FFLAG_OF;}
+    if (exceptions & FE_DIVBYZERO) {fflags |= FFLAG_DZ;}
+    if (exceptions & FE_INVALID) {fflags |= FFLAG_NV;}
+
+    // Leave the host in its default mode for the rest of the emulator
+    fesetround(FE_TONEAREST);
+    return fflags;
+}
+
+inline float FloatingPointUnit::toFloat(uint32_t bits) {
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+inline uint32_t FloatingPointUnit::toBits(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline bool FloatingPointUnit::isNan(uint32_t bits) {
+    return (bits & 0x7fffffff) > 0x7f800000;
+}
+
+inline bool FloatingPointUnit::isSignalingNan(uint32_t bits) {
+    return isNan(bits) && !(bits & 0x400000);
+}
+
+inline uint32_t FloatingPointUnit::canonicalize(float value) {
+    return std::isnan(value) ? CANONICAL_NAN : toBits(value);
+}
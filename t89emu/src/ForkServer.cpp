@@ -0,0 +1,190 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <signal.h>
+#include <sys/shm.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include "ForkServer.h"
+
+ForkServer::ForkServer(Machine *machine, const ForkServerOptions &options)
+    : machine(machine), options(options), returnAddress(0) {
+
+}
+
+bool ForkServer::boot(uint64_t maxInstructions) {
+    Mcu *mcu = machine->getMcu();
+    Smp *smp = machine->getSmp();
+    ProgramCounter *pc = mcu->getProgramCounterModule();
+    SemihostMemoryDevice *semihost = mcu->getSemihostDevice();
+
+    for (uint64_t count = 0; pc->getPc() != options.startPc; count++) {
+        if ((maxInstructions && count >= maxInstructions) ||
+            semihost->hasExited()) {
+            return false;
+        }
+
+        for (uint32_t hartId = 0; hartId < smp->getNumHarts(); hartId++) {
+            Mcu *hart = smp->getHart(hartId);
+            uint64_t exceptions = hart->getExceptionCount();
+            hart->nextInstruction();
+            if (hart->getExceptionCount() != exceptions &&
+                isCrash(hart->getLastException())) {
+                return false;
+            }
+        }
+    }
+
+    returnAddress = mcu->getRegisterFileModule()->read(1); // ra
+    return true;
+}
+
+int ForkServer::serve() {
+    attachCoverageMap();
+
+    // The fuzzer expects four bytes once the server is up. If nobody is
+    // listening, run the input once as a normal process
+    uint32_t message = 0;
+    if (write(FORKSRV_STATUS_FD, &message, sizeof(message)) !=
+        sizeof(message)) {
+        return execute();
+    }
+
+    while (read(FORKSRV_CONTROL_FD, &message, sizeof(message)) ==
+           sizeof(message)) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return EXIT_FAILURE;
+        }
+        if (pid == 0) {
+            close(FORKSRV_CONTROL_FD);
+            close(FORKSRV_STATUS_FD);
+            _exit(execute());
+        }
+
+        int status;
+        if (write(FORKSRV_STATUS_FD, &pid, sizeof(pid)) != sizeof(pid) ||
+            waitpid(pid, &status, 0) < 0 ||
+            write(FORKSRV_STATUS_FD, &status, sizeof(status)) !=
+                sizeof(status)) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int ForkServer::execute() {
+    Mcu *mcu = machine->getMcu();
+    Smp *smp = machine->getSmp();
+
+    // Read at most inputSize bytes of the test input
+    FILE *file = options.inputPath ? fopen(options.inputPath, "rb") : stdin;
+    if (!file) {
+        perror(options.inputPath);
+        return EXIT_FAILURE;
+    }
+    std::vector<uint8_t> input(options.inputSize);
+    size_t inputLength = fread(input.data(), 1, input.size(), file);
+    if (file != stdin) {
+        fclose(file);
+    }
+
+    if (inputLength && mcu->getBusModule()->writeBlock(
+                           options.inputAddress, input.data(),
+                           inputLength) != STATUS_OK) {
+        fprintf(stderr, "ForkServer.cpp: input buffer is not writable\n");
+        return EXIT_FAILURE;
+    }
+    RegisterFile *rf = mcu->getRegisterFileModule();
+    rf->write(options.inputAddress, 10); // a0
+    rf->write(inputLength, 11);          // a1
+
+    for (uint32_t hartId = 0; hartId < smp->getNumHarts(); hartId++) {
+        smp->getHart(hartId)->resetCoverageLocation();
+    }
+
+    ProgramCounter *pc = mcu->getProgramCounterModule();
+    SemihostMemoryDevice *semihost = mcu->getSemihostDevice();
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::duration<double>(options.run.maxSeconds);
+    uint64_t maxInstructions = options.run.maxInstructions;
+    for (uint64_t count = 0; !maxInstructions || count < maxInstructions;
+         count++) {
+        for (uint32_t hartId = 0; hartId < smp->getNumHarts(); hartId++) {
+            Mcu *hart = smp->getHart(hartId);
+            uint64_t exceptions = hart->getExceptionCount();
+            hart->nextInstruction();
+            if (hart->getExceptionCount() != exceptions &&
+                isCrash(hart->getLastException())) {
+                fprintf(stderr, "crash: exception %u on hart %u\n",
+                        hart->getLastException(), hartId);
+                abort();
+            }
+        }
+
+        // The low 8 bits become the child's status, a non-zero code must
+        // not read as a clean return
+        if (semihost->hasExited()) {
+            uint32_t exitCode = semihost->getExitCode();
+            return (exitCode & 0xff) || !exitCode ? (int)(exitCode & 0xff)
+                                                  : EXIT_FAILURE;
+        }
+        if (pc->getPc() == returnAddress) {
+            return EXIT_SUCCESS;
+        }
+        if (options.run.maxSeconds && (count % RUNNER_CHECK_INTERVAL) == 0 &&
+            std::chrono::steady_clock::now() >= deadline) {
+            break;
+        }
+    }
+
+    return FORKSRV_LIMIT_STATUS;
+}
+
+void ForkServer::attachCoverageMap() {
+    const char *shmId = getenv(FORKSRV_SHM_ENV);
+    if (!shmId) {
+        return;
+    }
+
+    uint32_t mapSize = FORKSRV_MAP_SIZE;
+    const char *mapSizeValue = getenv(FORKSRV_MAP_SIZE_ENV);
+    if (mapSizeValue) {
+        mapSize = strtoul(mapSizeValue, nullptr, 0);
+    }
+    if (mapSize == 0 || (mapSize & (mapSize - 1))) {
+        fprintf(stderr, "ForkServer.cpp: map size is not a power of two\n");
+        return;
+    }
+
+    void *map = shmat(atoi(shmId), nullptr, 0);
+    if (map == (void *)-1) {
+        perror("shmat");
+        return;
+    }
+
+    Smp *smp = machine->getSmp();
+    for (uint32_t hartId = 0; hartId < smp->getNumHarts(); hartId++) {
+        smp->getHart(hartId)->setCoverageMap((uint8_t *)map, mapSize);
+    }
+}
+
+bool ForkServer::isCrash(uint32_t exceptionCode) {
+    switch (exceptionCode) {
+    case INSTRUCTION_ADDRESS_MISALIGNED:
+    case INSTRUCTION_ACCESS_FAULT:
+    case ILLEGAL_INSTRUCTION:
+    case BREAKPOINT:
+    case LOAD_ADDRESS_MISALIGNED:
+    case LOAD_ACCESS_FAULT:
+    case STORE_ADDRESS_MISALIGNED:
+    case STORE_ACCESS_FAULT:
+        return true;
+    default:
+        return false;
+    }
+}
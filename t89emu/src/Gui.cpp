@@ -1,13 +1,9 @@
 #include "Gui.h"
 
-struct funcs {
-    static bool IsLegacyNativeDupe(ImGuiKey key) {
-        return key < 512 && ImGui::GetIO().KeyMap[key] != -1;
-    }
-};  // Hide Native<>ImGuiKey duplicates when both exists in the array
-
-Gui::Gui(McuDebug *debug) : debug(debug), doStepI(false), doStep(false),
-        forceSourceCodeScroll(false), isRunEnabled(false) {
+Gui::Gui(Debugger *debug) : debug(debug), doStepI(false), doStep(false),
+        forceSourceCodeScroll(false), isRunEnabled(false),
+        isReloadFailed(false),
+        breakpointHexBuf(), jumpHexBuf() {
     // Call vendor specific initializer code
     if (initImGuiInstance()) {
         exit(EXIT_FAILURE);
@@ -31,12 +27,35 @@ Gui::Gui(McuDebug *debug) : debug(debug), doStepI(false), doStep(false),
         registers.push_back(std::make_pair(regName, 0));
     }
 
-    // Initialize VRAM Viewer
+    // Initialize VRAM Viewer, texture storage is allocated once and then
+    // updated a row span at a time
     glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, textureW, textureH, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, nullptr);
     vramFont = ImGui::GetIO().Fonts->AddFontFromFileTTF("./egaFont.ttf", 10.8);
 
-    // Initialize I/O Panel Viewer
-    buttons = {ImGuiKey_Tab, ImGuiKey_W, ImGuiKey_A, ImGuiKey_S, ImGuiKey_D};
+    // Initialize I/O Panel Viewer, scancodes are USB HID usage IDs
+    for (int i = 0; i < 26; i++) {
+        keyScancodes.push_back({(ImGuiKey)(ImGuiKey_A + i), 0x04 + i});
+    }
+    for (int i = 0; i < 9; i++) {
+        keyScancodes.push_back({(ImGuiKey)(ImGuiKey_1 + i), 0x1e + i});
+    }
+    keyScancodes.push_back({ImGuiKey_0, 0x27});
+    keyScancodes.push_back({ImGuiKey_Enter, 0x28});
+    keyScancodes.push_back({ImGuiKey_Escape, 0x29});
+    keyScancodes.push_back({ImGuiKey_Backspace, 0x2a});
+    keyScancodes.push_back({ImGuiKey_Tab, 0x2b});
+    keyScancodes.push_back({ImGuiKey_Space, 0x2c});
+    keyScancodes.push_back({ImGuiKey_RightArrow, 0x4f});
+    keyScancodes.push_back({ImGuiKey_LeftArrow, 0x50});
+    keyScancodes.push_back({ImGuiKey_DownArrow, 0x51});
+    keyScancodes.push_back({ImGuiKey_UpArrow, 0x52});
+    keyScancodes.push_back({ImGuiKey_LeftCtrl, 0xe0});
+    keyScancodes.push_back({ImGuiKey_LeftShift, 0xe1});
 }
 
 Gui::~Gui() {
@@ -184,22 +203,38 @@ void Gui::renderControlPanel() {
 
     ImGui::Checkbox("Run", &isRunEnabled);
 
+    // Restart the firmware, reload picks up a rebuilt ELF file
+    if (ImGui::Button("reset")) {
+        debug->reset();
+        isReloadFailed = false;
+        forceSourceCodeScroll = true;
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("reload")) {
+        isReloadFailed = !debug->reload();
+        forceSourceCodeScroll = true;
+    }
+    if (isReloadFailed) {
+        ImGui::Text("Reload failed, running the previous firmware");
+    }
+
     ImGui::End();
 }
 
 void Gui::renderDisassembledCodeSection() {
     ImGui::Begin("Disassembly");
-    static char hexBuf[9] = {0x00};
     if (ImGui::BeginTable("jumps", 1, ImGuiTableFlags_BordersInnerV)) {
         // Manually Typed Address
         ImGui::TableNextColumn();
         ImGui::Text("Breakpoint ");
         ImGui::SameLine();
         ImGui::SetNextItemWidth(100);
-        ImGui::InputTextWithHint("###jump to", "address", hexBuf, 9,
+        ImGui::InputTextWithHint("###jump to", "address", breakpointHexBuf,
+                                 sizeof(breakpointHexBuf),
                                  ImGuiInputTextFlags_CharsHexadecimal |
                                      ImGuiInputTextFlags_CharsUppercase);
-        uint32_t breakpointAddress = (uint32_t)strtol(hexBuf, NULL, 16);
+        uint32_t breakpointAddress =
+            (uint32_t)strtol(breakpointHexBuf, NULL, 16);
         ImGui::SameLine();
         if (ImGui::Button("set")) {
             debug->addBreakpoint(breakpointAddress);
@@ -218,7 +253,7 @@ void Gui::renderDisassembledCodeSection() {
     uint32_t pc = pcProbe->getPc();
 
     // Begin Table
-    static ImGuiTableFlags tableFlags = ImGuiTableFlags_RowBg;
+    ImGuiTableFlags tableFlags = ImGuiTableFlags_RowBg;
     if (!ImGui::BeginTable("table1", 1, tableFlags)) {
         return;
     }
@@ -284,26 +319,21 @@ void Gui::renderFrame() {
 }
 
 void Gui::renderIoPanel() {
-    uint8_t *csrMemBuffer = csrMemProbe->getBuffer();
-    uint32_t *keyboardCsr = (uint32_t *)&csrMemBuffer[16];
-
     ImGui::Begin("External I/O");
     ImGui::Text("Button Pressed:");
-    // Check for buttons pressed
-    for (ImGuiKey const &key : buttons) {
-        if (funcs::IsLegacyNativeDupe(key)) continue;
-        if (ImGui::IsKeyDown(key)) {
-            ImGui::Text("\"%s\" %d", ImGui::GetKeyName(key), key);
-            // Set Bit Flag in Keyboard CSR
-            for (size_t i = 0; i < buttons.size(); i++) {
-                if (key == buttons.at(i)) {
-                    // i specifies what bit "key" maps to
-                    *keyboardCsr = (1 << i);
-                }
-            }
-            break;
-        } else {
-            *keyboardCsr = 0;
+    // Forward key transitions to the keyboard device, through the input
+    // log so they can be recorded
+    InputLog *inputLog = debug->getInputLog();
+    for (const std::pair<ImGuiKey, uint16_t> &key : keyScancodes) {
+        if (ImGui::IsKeyPressed(key.first, false)) {
+            inputLog->injectKey(key.second, false);
+        } else if (ImGui::IsKeyReleased(key.first)) {
+            inputLog->injectKey(key.second, true);
+        }
+
+        if (ImGui::IsKeyDown(key.first)) {
+            ImGui::Text("\"%s\" 0x%02x", ImGui::GetKeyName(key.first),
+                        key.second);
         }
     }
     ImGui::End();
@@ -334,21 +364,21 @@ void Gui::renderLcdDisplay() {
             ImGui::Text("%s", lineStr);
         }
         ImGui::PopFont();
-    } else if (videoMode == GRAPHICS_MODE) {
+    } else if (VideoMemoryDevice::isGraphicsMode(videoMode)) {
         ImVec2 uvMin = ImVec2(0.0f, 0.0f);                  // Top-left
         ImVec2 uvMax = ImVec2(1.0f, 1.0f);                  // Lower-right
         ImVec4 tintCol = ImVec4(1.0f, 1.0f, 1.0f, 1.0f);    // No tint
         ImVec4 borderCol = ImVec4(1.0f, 1.0f, 1.0f, 0.5f);  // 50% opaque white
 
-        uint8_t *vramBuffer =
-            (uint8_t *)(vramProbe->getBuffer() + 16 +
-                        vramProbe->getTWidth() * vramProbe->getTHeight());
-
+        // Only rows the guest changed since the last frame are uploaded,
+        // flipping guests therefore upload only after a flip
+        uint8_t *frame = vramProbe->presentFrame(dirtySpans);
         glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, textureW, textureH, 0, GL_RGBA,
-                     GL_UNSIGNED_BYTE, vramBuffer);
+        for (std::pair<uint32_t, uint32_t> &span : dirtySpans) {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, span.first, textureW,
+                            span.second, GL_RGBA, GL_UNSIGNED_BYTE,
+                            frame + span.first * (uint32_t)textureW * 4);
+        }
         ImGui::Image((void *)(intptr_t)textureID, ImVec2(textureW, textureH),
                      uvMin, uvMax, tintCol, borderCol);
     }
@@ -358,7 +388,6 @@ void Gui::renderLcdDisplay() {
 
 // Based on https://github.com/ThomasRinsma/dromaius
 void Gui::renderMemoryViewer() {
-    static char hexBuf[9] = {0x00};
     int jumpAddr = -1;
 
     // const float TEXT_BASE_WIDTH = ImGui::CalcTextSize("A").x;
@@ -369,12 +398,13 @@ void Gui::renderMemoryViewer() {
         // Manually Typed Address
         ImGui::TableNextColumn();
         ImGui::SetNextItemWidth(100);
-        ImGui::InputTextWithHint("###jump to", "address", hexBuf, 9,
+        ImGui::InputTextWithHint("###jump to", "address", jumpHexBuf,
+                                 sizeof(jumpHexBuf),
                                  ImGuiInputTextFlags_CharsHexadecimal |
                                      ImGuiInputTextFlags_CharsUppercase);
         ImGui::SameLine();
         if (ImGui::Button("go to addr"))
-            jumpAddr = (int)strtol(hexBuf, NULL, 16);
+            jumpAddr = (int)strtol(jumpHexBuf, NULL, 16);
 
         // Memory Section Button
         ImGui::TableNextColumn();
@@ -434,7 +464,7 @@ void Gui::renderMemoryViewer() {
 
 // Render General Purpose and Control State Registers
 void Gui::renderRegisterBank() {
-    static ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg;
+    ImGuiTableFlags flags = ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg;
     std::vector<int> csrAddress = {CSR_MSTATUS, CSR_MISA,     CSR_MIE,
                                    CSR_MTVEC,   CSR_MSCRATCH, CSR_MEPC,
                                    CSR_MCAUSE,  CSR_MTVAL,    CSR_MIP};
@@ -444,7 +474,7 @@ void Gui::renderRegisterBank() {
                                         "mcause",  "mtval",    "mip"};
 
     std::vector<std::string> csrMemName = {"mcycle_l", "mcycle_h", "mtimecmp_l",
-                                           "mtimecmp_h", "keyboard"};
+                                           "mtimecmp_h"};
 
     ImGui::Begin("Registers");
     if (ImGui::BeginTable("Registers", 2, flags)) {
@@ -541,7 +571,7 @@ void Gui::renderDebugSource() {
     ImGui::BeginTabBar("sourceCodeTabBar", tabBarFlags);
 
     uint sourceLineAtPc = debug->getLineNumberAtPc();
-    std::string &sourceNameAtPc = debug->getSourceNameAtPc();
+    const std::string &sourceNameAtPc = debug->getSourceNameAtPc();
 
     for (SourceInfo *source : debug->getSourceInfo()) {
         ImGuiTabItemFlags tabFlags = 0;
@@ -45,6 +45,7 @@ uint32_t ImmediateGenerator::getImmediate(uint32_t instruction) {
             immediate |= 0xfffff000;
         return immediate <<= 1; // shift offset left by 1
     case LOAD: // Loads
+    case LOAD_FP: // flw
         immediate = instruction >> 20; // 12 bit immediate
         if (instruction >> 31) {
             // MSB of immediate is 1 (store backwards)
@@ -52,6 +53,7 @@ uint32_t ImmediateGenerator::getImmediate(uint32_t instruction) {
         }
         return immediate;
     case STORE: // Stores
+    case STORE_FP: // fsw
         immediate = ((instruction >> 20) & (0b1111111 << 5)) +
                     ((instruction >> 7) & 0b11111);
         if (instruction >> 31) {
@@ -0,0 +1,167 @@
+#include "InputLog.h"
+
+#include <cstring>
+#include <iostream>
+
+InputLog::InputLog(Mcu *bootHart)
+    : mode(MODE_OFF), file(nullptr), isDiverged(false), lastCycle(0),
+      lastTime(0), next(), hasNext(false),
+      scheduler(bootHart->getEventSchedulerModule()),
+      keyboard(bootHart->getKeyboardDevice()),
+      semihost(bootHart->getSemihostDevice()) {
+
+}
+
+InputLog::~InputLog() {
+    semihost->setInputLog(nullptr);
+    if (file) {
+        fclose(file);
+    }
+}
+
+bool InputLog::record(const char *path) {
+    file = fopen(path, "wb");
+    if (!file) {
+        return false;
+    }
+
+    fwrite(INPUTLOG_MAGIC, 1, strlen(INPUTLOG_MAGIC), file);
+    fputc(INPUTLOG_VERSION, file);
+    mode = MODE_RECORD;
+    semihost->setInputLog(this);
+    return true;
+}
+
+bool InputLog::replay(const char *path) {
+    file = fopen(path, "rb");
+    if (!file) {
+        return false;
+    }
+
+    char header[sizeof(INPUTLOG_MAGIC)] = {};
+    size_t magicSize = strlen(INPUTLOG_MAGIC);
+    if (fread(header, 1, sizeof(header), file) != sizeof(header) ||
+        memcmp(header, INPUTLOG_MAGIC, magicSize) ||
+        header[magicSize] != INPUTLOG_VERSION) {
+        fclose(file);
+        file = nullptr;
+        return false;
+    }
+
+    mode = MODE_REPLAY;
+    semihost->setInputLog(this);
+    readRecord();
+    return true;
+}
+
+void InputLog::injectKey(uint16_t scancode, bool isRelease) {
+    switch (mode) {
+    case MODE_OFF:
+        keyboard->pushEvent(scancode, isRelease);
+        break;
+    case MODE_RECORD:
+        // Between instructions the cycle belongs to the last instruction,
+        // deliver before the next one like a scheduled event
+        scheduler->schedule(scheduler->getCycle() + 1,
+                            [this, scancode, isRelease]() {
+            writeRecord(INPUTLOG_KEY,
+                        scancode | (isRelease ? KEYBOARD_EVENT_RELEASE : 0));
+            keyboard->pushEvent(scancode, isRelease);
+        });
+        break;
+    case MODE_REPLAY:
+        break;
+    }
+}
+
+uint64_t InputLog::readTime(uint64_t hostTime) {
+    if (mode == MODE_RECORD) {
+        writeRecord(INPUTLOG_TIME, hostTime - lastTime);
+        lastTime = hostTime;
+    } else if (mode == MODE_REPLAY) {
+        if (hasNext && next.type == INPUTLOG_TIME &&
+            next.cycle == scheduler->getCycle()) {
+            lastTime += next.payload;
+            readRecord();
+        } else {
+            diverge("time read not in the log");
+        }
+    } else {
+        return hostTime;
+    }
+
+    return lastTime;
+}
+
+bool InputLog::hasDiverged() {
+    return isDiverged || (hasNext && next.type == INPUTLOG_TIME &&
+                          next.cycle < scheduler->getCycle());
+}
+
+void InputLog::writeRecord(uint8_t type, uint64_t payload) {
+    uint64_t cycle = scheduler->getCycle();
+    writeVarint(cycle - lastCycle);
+    fputc(type, file);
+    writeVarint(payload);
+    lastCycle = cycle;
+}
+
+bool InputLog::readRecord() {
+    uint64_t cycleDelta;
+    int type;
+    hasNext = readVarint(&cycleDelta) && (type = fgetc(file)) != EOF &&
+              readVarint(&next.payload);
+    if (!hasNext) {
+        return false;
+    }
+
+    lastCycle += cycleDelta;
+    next.cycle = lastCycle;
+    next.type = type;
+    if (next.type == INPUTLOG_KEY) {
+        uint16_t scancode = next.payload & KEYBOARD_EVENT_SCANCODE;
+        bool isRelease = next.payload & KEYBOARD_EVENT_RELEASE;
+        scheduler->schedule(next.cycle, [this, scancode, isRelease]() {
+            keyboard->pushEvent(scancode, isRelease);
+            readRecord();
+        });
+    } else if (next.type != INPUTLOG_TIME) {
+        diverge("unknown record type");
+        hasNext = false;
+    }
+
+    return hasNext;
+}
+
+void InputLog::writeVarint(uint64_t value) {
+    // 7 bits per byte, least significant first, high bit continues
+    while (value >= 0x80) {
+        fputc((value & 0x7f) | 0x80, file);
+        value >>= 7;
+    }
+    fputc(value, file);
+}
+
+bool InputLog::readVarint(uint64_t *value) {
+    *value = 0;
+    for (uint32_t shift = 0; shift < 64; shift += 7) {
+        int byte = fgetc(file);
+        if (byte == EOF) {
+            return false;
+        }
+        *value |= (uint64_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void InputLog::diverge(const char *reason) {
+    if (!isDiverged) {
+        std::cerr << "InputLog: replay diverged at cycle "
+                  << scheduler->getCycle() << ": " << reason << "\n";
+    }
+    isDiverged = true;
+}
@@ -0,0 +1,151 @@
+#include "KeyboardMemoryDevice.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+KeyboardMemoryDevice::KeyboardMemoryDevice(uint32_t base, uint32_t size,
+                                           EventScheduler *scheduler,
+                                           PlicMemoryDevice *plic,
+                                           uint32_t irq)
+    : MemoryDevice::MemoryDevice(base, size), isOverflow(false),
+      scheduler(scheduler), plic(plic), irq(irq) {
+
+}
+
+uint32_t KeyboardMemoryDevice::read(uint32_t addr, uint32_t size,
+                                    uint32_t *readValue) {
+    // Registers are only accessible as words
+    if (!checkAlignment(addr, size) || size != WORD) {
+        return LOAD_ADDRESS_MISALIGNED;
+    }
+
+    if (addr - baseAddress == KEYBOARD_EVENT_OFFSET) {
+        popEvent();
+    }
+
+    *readValue = *((uint32_t *)getAddress(addr));
+
+    return STATUS_OK;
+}
+
+uint32_t KeyboardMemoryDevice::write(uint32_t addr, uint32_t value,
+                                     uint32_t size) {
+    if (!checkAlignment(addr, size) || size != WORD) {
+        return STORE_ADDRESS_MISALIGNED;
+    }
+
+    // Status, event and timestamp are read only
+    if (addr - baseAddress == KEYBOARD_CONTROL_OFFSET &&
+        (value & KEYBOARD_CONTROL_FLUSH)) {
+        fifo.clear();
+        isOverflow = false;
+        updateStatus();
+    }
+
+    return STATUS_OK;
+}
+
+void KeyboardMemoryDevice::pushEvent(uint16_t scancode, bool isRelease) {
+    if (fifo.size() == KEYBOARD_FIFO_DEPTH) {
+        isOverflow = true;
+        updateStatus();
+        return;
+    }
+
+    fifo.push_back({scheduler->getCycle(), scancode, isRelease});
+    updateStatus();
+
+    // Interrupt when the FIFO stops being empty
+    if (fifo.size() == 1) {
+        plic->raiseInterrupt(irq);
+    }
+}
+
+bool KeyboardMemoryDevice::loadScript(const char *path) {
+    std::ifstream script(path);
+    if (!script.is_open()) {
+        return false;
+    }
+
+    std::string line;
+    while (std::getline(script, line)) {
+        line = line.substr(0, line.find('#'));
+
+        std::istringstream fields(line);
+        uint64_t cycle;
+        std::string action;
+        std::string scancodeStr;
+        if (!(fields >> cycle)) {
+            continue; // Blank or comment line
+        }
+
+        char *end = nullptr;
+        unsigned long scancode = 0;
+        if (fields >> action >> scancodeStr) {
+            scancode = strtoul(scancodeStr.c_str(), &end, 0);
+        }
+        if (end == nullptr || end == scancodeStr.c_str() || *end != '\0' ||
+            (action != "press" && action != "release")) {
+            std::cerr << "KeyboardMemoryDevice: bad script line: " << line
+                      << "\n";
+            return false;
+        }
+
+        bool isRelease = action == "release";
+        scheduler->schedule(cycle, [this, scancode, isRelease]() {
+            pushEvent((uint16_t)scancode, isRelease);
+        });
+    }
+
+    return true;
+}
+
+void KeyboardMemoryDevice::saveState(std::vector<uint8_t> &state) {
+    MemoryDevice::saveState(state);
+    appendState(state, isOverflow);
+    appendState(state, (uint32_t)fifo.size());
+    for (const KeyEvent &event : fifo) {
+        appendState(state, event);
+    }
+}
+
+void KeyboardMemoryDevice::restoreState(const std::vector<uint8_t> &state) {
+    MemoryDevice::restoreState(state);
+    size_t offset = deviceSize;
+    uint32_t numEvents;
+    loadState(state, &offset, &isOverflow);
+    loadState(state, &offset, &numEvents);
+    fifo.resize(numEvents);
+    for (KeyEvent &event : fifo) {
+        loadState(state, &offset, &event);
+    }
+}
+
+void KeyboardMemoryDevice::popEvent() {
+    uint32_t *event = (uint32_t *)&mem[KEYBOARD_EVENT_OFFSET];
+    uint32_t *timestamp = (uint32_t *)&mem[KEYBOARD_TIMESTAMP_OFFSET];
+
+    if (fifo.empty()) {
+        *event = 0;
+        return;
+    }
+
+    KeyEvent &next = fifo.front();
+    *event = KEYBOARD_EVENT_VALID | next.scancode |
+             (next.isRelease ? KEYBOARD_EVENT_RELEASE : 0);
+    *timestamp = next.cycle;
+    fifo.pop_front();
+    updateStatus();
+
+    // Sources are edge triggered, signal again for the remaining events
+    if (!fifo.empty()) {
+        plic->raiseInterrupt(irq);
+    }
+}
+
+void KeyboardMemoryDevice::updateStatus() {
+    uint32_t *status = (uint32_t *)&mem[KEYBOARD_STATUS_OFFSET];
+    *status = fifo.size() | (isOverflow ? KEYBOARD_STATUS_OVERFLOW : 0);
+}
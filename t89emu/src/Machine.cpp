@@ -0,0 +1,119 @@
+#include "Machine.h"
+
+#include <cstring>
+
+Machine::Machine(const char *elfPath, uint32_t numHarts)
+    : elfParser(new ElfParser(elfPath)), isElfParserOwned(true) {
+    init(numHarts);
+}
+
+Machine::Machine(ElfParser *elfParser, uint32_t numHarts)
+    : elfParser(elfParser), isElfParserOwned(false) {
+    init(numHarts);
+}
+
+Machine::~Machine() {
+    delete smp;
+    if (isElfParserOwned) {
+        delete elfParser;
+    }
+}
+
+Smp *Machine::getSmp() {
+    return smp;
+}
+
+uint32_t Machine::getNumHarts() {
+    return smp->getNumHarts();
+}
+
+Mcu *Machine::getMcu() {
+    return smp->getHart(0);
+}
+
+ElfParser *Machine::getElfParser() {
+    return elfParser;
+}
+
+void Machine::saveSnapshot(Snapshot &snapshot) {
+    Mcu *mcu = getMcu();
+    std::vector<MemoryDevice *> &devices = mcu->getBusModule()->getDevices();
+
+    snapshot.harts.resize(getNumHarts());
+    for (uint32_t hartId = 0; hartId < getNumHarts(); hartId++) {
+        smp->getHart(hartId)->saveState(snapshot.harts[hartId]);
+    }
+
+    snapshot.devices.resize(devices.size());
+    for (size_t i = 0; i < devices.size(); i++) {
+        if (devices[i] != mcu->getRomDevice()) {
+            devices[i]->saveState(snapshot.devices[i]);
+        }
+    }
+
+    snapshot.scheduler = *mcu->getEventSchedulerModule();
+}
+
+void Machine::restoreSnapshot(const Snapshot &snapshot) {
+    Mcu *mcu = getMcu();
+    std::vector<MemoryDevice *> &devices = mcu->getBusModule()->getDevices();
+
+    for (uint32_t hartId = 0; hartId < getNumHarts(); hartId++) {
+        smp->getHart(hartId)->restoreState(snapshot.harts[hartId]);
+    }
+
+    for (size_t i = 0; i < devices.size(); i++) {
+        if (devices[i] != mcu->getRomDevice()) {
+            devices[i]->restoreState(snapshot.devices[i]);
+        }
+    }
+
+    *mcu->getEventSchedulerModule() = snapshot.scheduler;
+}
+
+void Machine::markLoaded() {
+    saveSnapshot(loadedState);
+}
+
+void Machine::reset() {
+    restoreSnapshot(loadedState);
+}
+
+bool Machine::load(ElfParser *newElfParser) {
+    Mcu *mcu = getMcu();
+    RomMemoryDevice *rom = mcu->getRomDevice();
+    if (newElfParser->getRomStart() != rom->getBaseAddress() ||
+        newElfParser->getRamStart() != mcu->getRamDevice()->getBaseAddress()) {
+        return false;
+    }
+
+    if (isElfParserOwned) {
+        delete elfParser;
+    }
+    elfParser = newElfParser;
+    isElfParserOwned = false;
+
+    // Devices and RAM as they were before the first image ran
+    restoreSnapshot(loadedState);
+
+    memset(rom->getBuffer(), 0, rom->getDeviceSize());
+    elfParser->flashRom(rom);
+
+    uint32_t entryPc = elfParser->getEntryPc();
+    for (uint32_t hartId = 0; hartId < getNumHarts(); hartId++) {
+        Mcu *hart = smp->getHart(hartId);
+        hart->invalidatePredecodeCache();
+        hart->getProgramCounterModule()->setPc(entryPc);
+        hart->getNextPcModule()->setNextPc(entryPc);
+    }
+
+    markLoaded();
+    return true;
+}
+
+void Machine::init(uint32_t numHarts) {
+    smp = new Smp(elfParser->getRomStart(), elfParser->getRamStart(),
+                  elfParser->getEntryPc(), numHarts);
+    elfParser->flashRom(getMcu()->getRomDevice());
+    markLoaded();
+}
@@ -5,87 +5,194 @@
 // Clint Memory Device
 #define CLINT_BASE                      0x30000000
 
+// Plic Memory Device
+#define PLIC_BASE                       0x31000000
+
+// Virtio Block Device (interrupt source 1 on the PLIC)
+#define VIRTIO_BLOCK_BASE               0x10001000
+#define VIRTIO_BLOCK_IRQ                1
+
+// Keyboard Device (interrupt source 4 on the PLIC)
+#define KEYBOARD_BASE                   0x10002000
+#define KEYBOARD_IRQ                    4
+
+// Semihosting channel to the host
+#define SEMIHOST_BASE                   0x10003000
+
 // RAM/ROM base address defined by linker
 #define RAM_SIZE                        1048576 // 1 MB
-#define ROM_SIZE                        2097152 // 2 MB
 
 // Video Memory Device (See Hardware Documentation)
 #define SCREEN_WIDTH                    512
 #define SCREEN_HEIGHT                   288
 #define TEXT_WIDTH                      64
 #define TEXT_HEIGHT                     21
+#define VIDEO_PAGES                     2
+#define VIDEO_VBLANK_CYCLES             1000000 // Default refresh period
+#define VIDEO_IRQ                       2
 #define VIDEO_BASE                      0x20000000
-#define VIDEO_SIZE                      (16 + TEXT_HEIGHT * TEXT_WIDTH + SCREEN_WIDTH * SCREEN_HEIGHT)
+#define VIDEO_SIZE                      (16 + TEXT_HEIGHT * TEXT_WIDTH + VIDEO_PAGES * SCREEN_WIDTH * SCREEN_HEIGHT * 4 + VIDEO_PALETTE_SIZE)
+
+// Blitter Device (interrupt source 3 on the PLIC)
+#define BLITTER_BASE                    0x20200000
+#define BLITTER_IRQ                     3
 
 Mcu::Mcu(uint32_t romBase, uint32_t ramBase, uint32_t entryPc) {
-    rf = new RegisterFile;
-    pc = new ProgramCounter;
-    csr = new Csr;
-    alu = new Alu;
-    aluc = new AluControlUnit;
-    immgen = new ImmediateGenerator;
-    mcu = new MemControlUnit;
-    nextPc = new NextPc;
+    initHart(0, romBase, entryPc);
+    isBootHart = true;
+
+    scheduler = new EventScheduler;
 #ifndef BUS_EXPERIMENTAL
     bus = new Bus(romBase, romSize, ramBase, ramSize);
 #else
     bus = new Bus();
     rom = new RomMemoryDevice(romBase, ROM_SIZE);
     ram = new RamMemoryDevice(ramBase, RAM_SIZE);
-    vram = new VideoMemoryDevice(VIDEO_BASE, VIDEO_SIZE, SCREEN_WIDTH,
-                                 SCREEN_HEIGHT, TEXT_WIDTH, TEXT_HEIGHT);
     clint = new ClintMemoryDevice(CLINT_BASE, CLINT_SIZE);
+    plic = new PlicMemoryDevice(PLIC_BASE, PLIC_SIZE);
+    vram = new VideoMemoryDevice(VIDEO_BASE, VIDEO_SIZE, SCREEN_WIDTH,
+                                 SCREEN_HEIGHT, TEXT_WIDTH, TEXT_HEIGHT,
+                                 VIDEO_PAGES, VIDEO_VBLANK_CYCLES, scheduler,
+                                 plic, VIDEO_IRQ);
+    virtioBlock = new VirtioBlockMemoryDevice(VIRTIO_BLOCK_BASE,
+                                              VIRTIO_MMIO_SIZE, bus, plic,
+                                              VIRTIO_BLOCK_IRQ);
+    blitter = new BlitterMemoryDevice(BLITTER_BASE, BLITTER_SIZE, bus, plic,
+                                      BLITTER_IRQ);
+    keyboard = new KeyboardMemoryDevice(KEYBOARD_BASE, KEYBOARD_SIZE,
+                                        scheduler, plic, KEYBOARD_IRQ);
+    semihost = new SemihostMemoryDevice(SEMIHOST_BASE, SEMIHOST_SIZE, bus);
     bus->addDevice(rom);
     bus->addDevice(ram);
     bus->addDevice(vram);
     bus->addDevice(clint);
+    bus->addDevice(plic);
+    bus->addDevice(virtioBlock);
+    bus->addDevice(blitter);
+    bus->addDevice(keyboard);
+    bus->addDevice(semihost);
 #endif // BUS_EXPERIMENTAL
-    trap = new Trap;
+    mmu = new Mmu(bus);
+}
 
-    pc->setPc(entryPc);
-    nextPc->setNextPc(entryPc);
+Mcu::Mcu(Mcu *bootHart, uint32_t hartId, uint32_t entryPc) {
+    initHart(hartId, bootHart->predecodeBase, entryPc);
+    isBootHart = false;
+
+    // Memory and devices belong to the boot hart
+    scheduler = bootHart->scheduler;
+    bus = bootHart->bus;
+#ifdef BUS_EXPERIMENTAL
+    rom = bootHart->rom;
+    ram = bootHart->ram;
+    vram = bootHart->vram;
+    clint = bootHart->clint;
+    plic = bootHart->plic;
+    virtioBlock = bootHart->virtioBlock;
+    blitter = bootHart->blitter;
+    keyboard = bootHart->keyboard;
+    semihost = bootHart->semihost;
+#endif // BUS_EXPERIMENTAL
+    mmu = new Mmu(bus);
 }
 
 Mcu::~Mcu() {
     delete rf;
     delete pc;
-    delete bus;
     delete csr;
+    delete frf;
+    delete fpu;
     delete alu;
     delete aluc;
     delete immgen;
     delete mcu;
     delete nextPc;
+    delete decoder;
     delete trap;
+    delete mmu;
+
+    if (!isBootHart) {
+        return;
+    }
+
+    delete bus;
+    delete scheduler;
+#ifdef BUS_EXPERIMENTAL
+    delete rom;
+    delete ram;
+    delete vram;
+    delete clint;
+    delete plic;
+    delete virtioBlock;
+    delete blitter;
+    delete keyboard;
+    delete semihost;
+#endif // BUS_EXPERIMENTAL
 }
 
 void Mcu::nextInstruction() {
+    uint32_t interruptType;
+
+    // Run device events that are due this cycle, devices are driven by
+    // the boot hart
+    if (isBootHart && scheduler->nextCycle()) {
+        bus->lockDevices();
+        scheduler->runEvents();
+        bus->unlockDevices();
+    }
+
     // Update Clint Device every cycle
 #ifndef BUS_EXPERIMENTAL
-    bus->getClintDevice()->nextCycle(csr);
+    bus->getClintDevice()->nextCycle(csr, hartId);
 
     // Check for interrupts
-    if (bus->getClintDevice()->checkInterrupts(csr)) {
-        trap->takeTrap(csr, pc, nextPc,
-                       bus->getClintDevice()->getInterruptType());
+    if (bus->getClintDevice()->checkInterrupts(csr, hartId, &interruptType)) {
+        trap->takeTrap(csr, pc, nextPc, interruptType);
+        mmu->update(csr);
+        if (coverageMap) {
+            recordEdge(pc->getPc());
+        }
     }
 #else
-    clint->nextCycle(csr);
+    clint->nextCycle(csr, hartId);
+
+    // External interrupts are only routed to the boot hart
+    if (isBootHart) {
+        plic->nextCycle(csr);
+    }
 
     // Check for interrupts
-    if (clint->checkInterrupts(csr)) {
-        trap->takeTrap(csr, pc, nextPc, clint->getInterruptType());
+    if (clint->checkInterrupts(csr, hartId, &interruptType)) {
+        trap->takeTrap(csr, pc, nextPc, interruptType);
+        mmu->update(csr);
+        if (coverageMap) {
+            recordEdge(pc->getPc());
+        }
     }
 #endif // BUS_EXPERIMENTAL
 
+    if (isWaiting) {
+        if (!(csr->readCsr(CSR_MIP) & csr->readCsr(CSR_MIE))) {
+            return;
+        }
+        isWaiting = false;
+    }
+
     uint32_t exceptionCode = executeInstruction();
     if (exceptionCode != STATUS_OK) {
+        exceptionCount++;
+        lastException = exceptionCode;
+
         // Hard to emulate accurately, but previous call to
         // execute_instruction() fails because exception is thrown. In a
         // real system, the CSRs and PC will change in the same cycle, so
         // the trap bit causes the PC to switch (mux) from the faulting
         // instruction to the jump instruction in the vector table
-        trap->takeTrap(csr, pc, nextPc, exceptionCode);
+        trap->takeTrap(csr, pc, nextPc, exceptionCode, trapValue);
+        mmu->update(csr);
+        if (coverageMap) {
+            recordEdge(pc->getPc());
+        }
 
         // Trap phase of cycle emulated (usually means control lines switch)
         // Now execute the jump instruction in the vector table
@@ -93,6 +200,70 @@ void Mcu::nextInstruction() {
     }
 }
 
+bool Mcu::isIdle() {
+    if (!isWaiting) {
+        return false;
+    }
+
+    clint->updatePending(csr, hartId);
+    return !(csr->readCsr(CSR_MIP) & csr->readCsr(CSR_MIE));
+}
+
+void Mcu::invalidatePredecodeCache() {
+    std::fill(predecodeCache.begin(), predecodeCache.end(),
+              PredecodedInstruction{0, 0});
+    std::fill(ramPredecodeCache.begin(), ramPredecodeCache.end(),
+              PredecodedInstruction{0, 0});
+}
+
+void Mcu::setCoverageMap(uint8_t *map, uint32_t size) {
+    coverageMap = map;
+    coverageMask = size - 1;
+    coveragePrevLocation = 0;
+}
+
+void Mcu::setExecutionMap(uint8_t *map) {
+    executionMap = map;
+}
+
+void Mcu::saveState(HartState &state) {
+    state.pc = pc->getPc();
+    for (int reg = 0; reg < 32; reg++) {
+        state.registers[reg] = rf->read(reg);
+        state.floatRegisters[reg] = frf->read(reg);
+    }
+    state.csrs = csr->getRegisters();
+    state.privilegeLevel = csr->getPrivilegeLevel();
+    state.isReserved = isReserved;
+    state.reservationAddr = reservationAddr;
+    state.reservationValue = reservationValue;
+    state.isWaiting = isWaiting;
+}
+
+void Mcu::restoreState(const HartState &state) {
+    pc->setPc(state.pc);
+    nextPc->setNextPc(state.pc);
+    for (int reg = 0; reg < 32; reg++) {
+        rf->write(state.registers[reg], reg);
+        frf->write(state.floatRegisters[reg], reg);
+    }
+    csr->getRegisters() = state.csrs;
+    csr->setPrivilegeLevel(state.privilegeLevel);
+    isReserved = state.isReserved;
+    reservationAddr = state.reservationAddr;
+    reservationValue = state.reservationValue;
+    isWaiting = state.isWaiting;
+
+    // Translations and permissions derive from the restored CSRs
+    mmu->update(csr);
+    mmu->flush(0, 0, true, true);
+    mmu->getPmp()->update(csr);
+}
+
+uint32_t Mcu::getHartId() {
+    return hartId;
+}
+
 Alu *Mcu::getAluModule() {
     return alu;
 }
@@ -109,10 +280,26 @@ Csr *Mcu::getCsrModule() {
     return csr;
 }
 
+EventScheduler *Mcu::getEventSchedulerModule() {
+    return scheduler;
+}
+
+FloatRegisterFile *Mcu::getFloatRegisterFileModule() {
+    return frf;
+}
+
+FloatingPointUnit *Mcu::getFloatingPointUnitModule() {
+    return fpu;
+}
+
 ImmediateGenerator *Mcu::getImmediateGeneratorModule() {
     return immgen;
 }
 
+Mmu *Mcu::getMmuModule() {
+    return mmu;
+}
+
 MemControlUnit *Mcu::getMemControlUnitModule() {
     return mcu;
 }
@@ -133,17 +320,67 @@ Trap *Mcu::getTrapModule() {
     return trap;
 }
 
+void Mcu::initHart(uint32_t hartId, uint32_t romBase, uint32_t entryPc) {
+    this->hartId = hartId;
+
+    rf = new RegisterFile;
+    pc = new ProgramCounter;
+    csr = new Csr;
+    frf = new FloatRegisterFile;
+    fpu = new FloatingPointUnit;
+    alu = new Alu;
+    aluc = new AluControlUnit;
+    immgen = new ImmediateGenerator;
+    mcu = new MemControlUnit;
+    nextPc = new NextPc;
+    decoder = new CompressedDecoder;
+    trap = new Trap;
+
+    csr->writeCsr(CSR_MHARTID, hartId);
+
+    predecodeBase = romBase;
+    predecodeCache.resize(ROM_SIZE / 2);
+    ramPredecodeCache.resize(RAM_SIZE / 2);
+    ramPageVersions.resize(RAM_SIZE >> CODE_PAGE_SHIFT);
+
+    isReserved = false;
+    reservationAddr = 0;
+    reservationValue = 0;
+    isWaiting = false;
+    trapValue = 0;
+    exceptionCount = 0;
+    lastException = STATUS_OK;
+    coverageMap = nullptr;
+    coverageMask = 0;
+    coveragePrevLocation = 0;
+    executionMap = nullptr;
+
+    pc->setPc(entryPc);
+    nextPc->setNextPc(entryPc);
+}
+
 uint32_t Mcu::executeInstruction() {
     // Fetch Stage
     uint32_t pcAddr = pc->getPc();  // Current PC
-    uint32_t curInstruction;
-    uint32_t exceptionCode =
-        bus->read(pcAddr, WORD, &curInstruction);  // Current Instruction
+    uint32_t curInstruction;        // Current Instruction (expanded)
+    uint32_t instructionLength;     // 2 if compressed, otherwise 4
+    uint32_t pcPaddr;               // Physical address of the PC
+    trapValue = 0;
+    uint32_t exceptionCode = fetchInstruction(pcAddr, &curInstruction,
+                                              &instructionLength, &pcPaddr);
     if (exceptionCode != STATUS_OK) {
         // Instruction Access fault or instruction address misaligned
         return exceptionCode;
     }
 
+    // The map covers ROM by physical address, so code mapped at another
+    // virtual address is marked where it is stored. Harts may share the
+    // map, a relaxed store keeps it a single store
+    if (executionMap && pcPaddr - predecodeBase < ROM_SIZE) {
+        __atomic_store_n(&executionMap[(pcPaddr - predecodeBase) >> 1], 1,
+                         __ATOMIC_RELAXED);
+    }
+
     // Decode Stage
     uint32_t opcode = curInstruction & 0b1111111;          // opcode field
     uint32_t funct3 = (curInstruction >> 12) & 0b111;      // funct3 field
@@ -162,6 +399,7 @@ uint32_t Mcu::executeInstruction() {
     uint32_t aluOpcode;
     uint32_t aluOutput;
     uint32_t readValue;
+    uint32_t returnPc = 0; // mepc/sepc for MRET/SRET
 
     switch (opcode) {
     case LUI:
@@ -174,13 +412,13 @@ uint32_t Mcu::executeInstruction() {
         break;
     case JAL:
         aluOpcode = aluc->getAluOperation(opcode, 0, 0);
-        aluOutput = alu->execute(pcAddr, 4, aluOpcode);
+        aluOutput = alu->execute(pcAddr, instructionLength, aluOpcode);
         rf->write(aluOutput, rd);
         break;
     case JALR:
         A = rf->read(rs1);
         aluOpcode = aluc->getAluOperation(opcode, 0, 0);
-        aluOutput = alu->execute(pcAddr, 4, aluOpcode);
+        aluOutput = alu->execute(pcAddr, instructionLength, aluOpcode);
         rf->write(aluOutput, rd);
         break;
     case BTYPE:
@@ -189,76 +427,92 @@ uint32_t Mcu::executeInstruction() {
         break;
     case LOAD:
         accessSize = mcu->getMemSize(funct3);
-        exceptionCode = bus->read(rf->read(rs1) + immediate, accessSize,
-                                  &readValue);
+        exceptionCode = loadData(rf->read(rs1) + immediate, accessSize,
+                                 &readValue);
         if (exceptionCode != STATUS_OK) {
             // "Throw" exception
             return exceptionCode;
         }
+        // Sign extend lb/lh
+        if (funct3 == 0b000) {
+            readValue = (int8_t)readValue;
+        } else if (funct3 == 0b001) {
+            readValue = (int16_t)readValue;
+        }
         rf->write(readValue, rd);
         break;
     case STORE:
         accessSize = mcu->getMemSize(funct3);
-        exceptionCode = bus->write(rf->read(rs1) + immediate,
-                                   rf->read(rs2), accessSize);
+        exceptionCode = storeData(rf->read(rs1) + immediate, rf->read(rs2),
+                                  accessSize);
         if (exceptionCode != STATUS_OK) {
             // "Throw" exception
             return exceptionCode;
         }
         break;
     case ITYPE:
-        aluOpcode = aluc->getAluOperation(opcode, funct7, funct3);
+        aluOpcode = aluc->getAluOperation(opcode, funct7, funct3, rs2);
+        if (aluOpcode == ALU_ILLEGAL) {
+            return ILLEGAL_INSTRUCTION;
+        }
         aluOutput = alu->execute(rf->read(rs1), immediate, aluOpcode);
         rf->write(aluOutput, rd);
         break;
     case RTYPE:
-        aluOpcode = aluc->getAluOperation(opcode, funct7, funct3);
+        aluOpcode = aluc->getAluOperation(opcode, funct7, funct3, rs2);
+        if (aluOpcode == ALU_ILLEGAL) {
+            return ILLEGAL_INSTRUCTION;
+        }
         aluOutput = alu->execute(rf->read(rs1), rf->read(rs2), aluOpcode);
         rf->write(aluOutput, rd);
         break;
-    case PRIV:
-        switch (funct3) {
-        case 0b000: // ECALL / MRET
-            switch (immediate) {
-            case MRET_IMM:
-                // MRET Instruction
-                // Restore MIE field from MPIE
-                if (csr->getMpie()) { // Set MIE if MPIE is 1
-                    csr->setMie();
-                }
-                // Set MPIE to 1
-                csr->setMpie();
-                // Set MPP to privilege mode before trap
-                csr->setMpp(MACHINE_MODE);
-                break;
-            case ECALL_IMM:
-                // Throw ecall from machine mode
-                return ECALL_FROM_M_MODE;
+    case AMO:
+        if (funct3 != 0b010) {
+            return ILLEGAL_INSTRUCTION; // Only word atomics on RV32
+        }
+        exceptionCode = executeAtomic(funct7 >> 2, rf->read(rs1),
+                                      rf->read(rs2), rd);
+        if (exceptionCode != STATUS_OK) {
+            return exceptionCode;
+        }
+        break;
+    case LOAD_FP:
+    case STORE_FP:
+    case FMADD:
+    case FMSUB:
+    case FNMSUB:
+    case FNMADD:
+    case OP_FP:
+        exceptionCode = executeFloat(curInstruction, immediate);
+        if (exceptionCode != STATUS_OK) {
+            return exceptionCode;
+        }
+        break;
+    case FENCE:
+        if (funct3 == 0b001) { // FENCE.I
+            // Stores from this hart already invalidate the pages they
+            // modify. Stores from other harts are only seen after FENCE.I,
+            // so every RAM page is checked again on its next fetch
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            for (uint32_t page = 0; page < ramPageVersions.size(); page++) {
+                ramPageVersions[page] = ram->getPageVersion(page) - 1;
             }
             break;
-        case 0b001:	// CSRRW
-            // Write current value of CSR to rd
-            rf->write(csr->readCsr(csrAddr), rd);
-            // Store value of rs1 into CSR
-            csr->writeCsr(csrAddr, rf->read(rs1));
-            break;
-        case 0b010:	// CSRRS
-            // Write current value of CSR to rd
-            rf->write(csr->readCsr(csrAddr), rd);
-            // Use rs1 as a bit mask to set CSR bits
-            if (rs1 != 0)
-                csr->writeCsr(csrAddr, rf->read(rs1) | csr->readCsr(csrAddr));
-            break;
-        case 0b011:	// CSRRC
-            // Write current value of CSR to rd
-            rf->write(csr->readCsr(csrAddr), rd);
-            // Usr rs1 as a bit mask to reset CSR bits
-            if (rs1 != 0)
-                csr->writeCsr(csrAddr, (!rf->read(rs1))&csr->readCsr(csrAddr));
-            break;
-        default:
-            // Immediate CSR Instructions not yet supported
-            break;
+        }
+        if (funct3 != 0b000) {
+            return ILLEGAL_INSTRUCTION;
+        }
+        // Order this hart's memory accesses against other hart threads
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        break;
+    case PRIV:
+        if (funct3 == 0b000) { // ECALL / MRET / SRET / WFI / SFENCE.VMA
+            exceptionCode = executeSystem(curInstruction, &returnPc);
+        } else {
+            exceptionCode = executeCsr(funct3, csrAddr, rs1, rd);
+        }
+        if (exceptionCode != STATUS_OK) {
+            return exceptionCode;
         }
         break;
     default:
@@ -268,16 +522,384 @@ uint32_t Mcu::executeInstruction() {
 
     // Update Program Counter
     exceptionCode = nextPc->calculateNextPc(immediate, opcode, funct3, A, B,
-                                            csr->getMepc());
+                                            returnPc, instructionLength);
     if (exceptionCode != STATUS_OK) {
         return exceptionCode;
     }
 
     pc->setPc(nextPc->getNextPc());
+
+    // Every jump, branch and trap return ends a basic block
+    if (coverageMap && (opcode == JAL || opcode == JALR || opcode == BTYPE ||
+                        (opcode == PRIV && funct3 == 0b000))) {
+        recordEdge(pc->getPc());
+    }
     
     return STATUS_OK;
 }
 
+uint32_t Mcu::fetchInstruction(uint32_t pcAddr, uint32_t *instruction,
+                               uint32_t *length, uint32_t *paddr) {
+    uint32_t exceptionCode = mmu->translate(pcAddr, HALFWORD, ACCESS_FETCH, paddr);
+    if (exceptionCode != STATUS_OK) {
+        trapValue = pcAddr;
+        return exceptionCode;
+    }
+
+    // The predecode caches are indexed by physical address
+    PredecodedInstruction *entry = getPredecodeEntry(*paddr);
+    if (entry && entry->length) {
+        *instruction = entry->instruction;
+        *length = entry->length;
+        return STATUS_OK;
+    }
+
+    // Instructions are fetched a halfword at a time
+    uint32_t lower;
+    exceptionCode = bus->read(*paddr, HALFWORD, &lower);
+    if (exceptionCode != STATUS_OK) {
+        trapValue = pcAddr;
+        return exceptionCode;
+    }
+
+    if (CompressedDecoder::isCompressed(lower)) {
+        *instruction = decoder->expand(lower);
+        *length = 2;
+    } else {
+        // The upper halfword may be on the next virtual page
+        uint32_t upperPaddr = *paddr + 2;
+        if (((pcAddr + 2) & (PAGE_SIZE - 1)) == 0) {
+            exceptionCode = mmu->translate(pcAddr + 2, HALFWORD,
+                                           ACCESS_FETCH, &upperPaddr);
+            if (exceptionCode != STATUS_OK) {
+                trapValue = pcAddr + 2;
+                return exceptionCode;
+            }
+            // Its mapping can change independently, do not cache it
+            entry = nullptr;
+        }
+
+        uint32_t upper;
+        exceptionCode = bus->read(upperPaddr, HALFWORD, &upper);
+        if (exceptionCode != STATUS_OK) {
+            trapValue = pcAddr + 2;
+            return exceptionCode;
+        }
+        *instruction = (upper << 16) | lower;
+        *length = 4;
+    }
+
+    if (entry) {
+        *entry = {*instruction, *length};
+    }
+
+    return STATUS_OK;
+}
+
+Mcu::PredecodedInstruction *Mcu::getPredecodeEntry(uint32_t paddr) {
+    if (paddr % 2 != 0) {
+        return nullptr;
+    }
+
+    uint32_t romIdx = (paddr - predecodeBase) / 2;
+    if (romIdx < predecodeCache.size()) {
+        return &predecodeCache[romIdx];
+    }
+
+    uint32_t ramOffset = paddr - ram->getBaseAddress();
+    if (ramOffset / 2 >= ramPredecodeCache.size()) {
+        return nullptr;
+    }
+
+    // Drop the page's entries if it was written since they were decoded
+    uint32_t page = ramOffset >> CODE_PAGE_SHIFT;
+    uint32_t version = ram->getPageVersion(page);
+    if (ramPageVersions[page] != version) {
+        auto first = ramPredecodeCache.begin() +
+                     (page << CODE_PAGE_SHIFT) / 2;
+        std::fill(first, first + CODE_PAGE_SIZE / 2,
+                  PredecodedInstruction{0, 0});
+        ramPageVersions[page] = version;
+    }
+
+    PredecodedInstruction *entry = &ramPredecodeCache[ramOffset / 2];
+    if (!entry->length) {
+        // The instruction is about to be decoded, watch the page for stores
+        ram->protectPage(page);
+    }
+    return entry;
+}
+
+uint32_t Mcu::executeAtomic(uint32_t funct5, uint32_t vaddr,
+                            uint32_t rs2Data, uint32_t rd) {
+    uint32_t readValue;
+    uint32_t exceptionCode;
+    uint32_t addr;
+    bool isSwapped;
+
+    if (vaddr % WORD != 0) {
+        trapValue = vaddr;
+        return (funct5 == AMO_LR) ? LOAD_ADDRESS_MISALIGNED
+                                  : STORE_ADDRESS_MISALIGNED;
+    }
+
+    // The reservation and AMOs work on physical addresses
+    // Writable pages and PMP regions are always readable, so checking AMOs
+    // as stores covers both
+    exceptionCode = mmu->translate(
+        vaddr, WORD, (funct5 == AMO_LR) ? ACCESS_LOAD : ACCESS_STORE, &addr);
+    if (exceptionCode != STATUS_OK) {
+        trapValue = vaddr;
+        return exceptionCode;
+    }
+
+    switch (funct5) {
+    case AMO_LR:
+        exceptionCode = bus->read(addr, WORD, &readValue);
+        if (exceptionCode != STATUS_OK) {
+            return exceptionCode;
+        }
+        isReserved = true;
+        reservationAddr = addr;
+        reservationValue = readValue;
+        rf->write(readValue, rd);
+        break;
+    case AMO_SC:
+        isSwapped = false;
+        if (isReserved && reservationAddr == addr) {
+            exceptionCode = bus->compareAndSwap(addr, reservationValue,
+                                                rs2Data, &isSwapped);
+            if (exceptionCode != STATUS_OK) {
+                return exceptionCode;
+            }
+        }
+        // Any SC ends the reservation, rd is 0 on success
+        isReserved = false;
+        rf->write(isSwapped ? 0 : 1, rd);
+        break;
+    case AMO_ADD:
+    case AMO_SWAP:
+    case AMO_XOR:
+    case AMO_OR:
+    case AMO_AND:
+    case AMO_MIN:
+    case AMO_MAX:
+    case AMO_MINU:
+    case AMO_MAXU:
+        exceptionCode = bus->atomicOperation(addr, funct5, rs2Data,
+                                             &readValue);
+        if (exceptionCode != STATUS_OK) {
+            return exceptionCode;
+        }
+        rf->write(readValue, rd);
+        break;
+    default:
+        return ILLEGAL_INSTRUCTION;
+    }
+
+    return STATUS_OK;
+}
+
+uint32_t Mcu::executeSystem(uint32_t instruction, uint32_t *returnPc) {
+    uint32_t immediate = instruction >> 20;
+    uint32_t rs1 = (instruction >> 15) & 0b11111;
+    uint32_t rs2 = (instruction >> 20) & 0b11111;
+    uint32_t privilegeLevel = csr->getPrivilegeLevel();
+
+    if ((immediate >> 5) == SFENCE_VMA_FUNCT7) {
+        if (privilegeLevel == USER_MODE) {
+            return ILLEGAL_INSTRUCTION;
+        }
+        // x0 selects all addresses / all address spaces
+        mmu->flush(rf->read(rs1), rf->read(rs2), rs1 == 0, rs2 == 0);
+        return STATUS_OK;
+    }
+
+    switch (immediate) {
+    case MRET_IMM:
+        if (privilegeLevel != MACHINE_MODE) {
+            return ILLEGAL_INSTRUCTION;
+        }
+        // Restore MIE field from MPIE, then set MPIE to 1
+        if (csr->getMpie()) {
+            csr->setMie();
+        } else {
+            csr->resetMie();
+        }
+        csr->setMpie();
+        // Return to the privilege level in MPP, MPP becomes U-mode
+        csr->setPrivilegeLevel(csr->getMpp());
+        if (csr->getMpp() != MACHINE_MODE) {
+            csr->resetMprv();
+        }
+        csr->resetMpp();
+        *returnPc = csr->getMepc();
+        break;
+    case SRET_IMM:
+        if (privilegeLevel == USER_MODE) {
+            return ILLEGAL_INSTRUCTION;
+        }
+        // Restore SIE field from SPIE, then set SPIE to 1
+        if (csr->getSpie()) {
+            csr->setSie();
+        } else {
+            csr->resetSie();
+        }
+        csr->setSpie();
+        // Return to the privilege level in SPP, SPP becomes U-mode
+        csr->setPrivilegeLevel(csr->getSpp());
+        csr->resetMprv();
+        csr->resetSpp();
+        *returnPc = csr->readCsr(CSR_SEPC);
+        break;
+    case ECALL_IMM:
+        switch (privilegeLevel) {
+        case USER_MODE: return ECALL_FROM_U_MODE;
+        case SUPERVISOR_MODE: return ECALL_FROM_S_MODE;
+        default: return ECALL_FROM_M_MODE;
+        }
+    case WFI_IMM:
+        // The hart idles from the next cycle on, see nextInstruction()
+        isWaiting = true;
+        return STATUS_OK;
+    default:
+        return STATUS_OK;
+    }
+
+    // The privilege level changed
+    mmu->update(csr);
+    return STATUS_OK;
+}
+
+uint32_t Mcu::executeCsr(uint32_t funct3, uint32_t csrAddr, uint32_t rs1,
+                         uint32_t rd) {
+    // CSRRS/CSRRC with rs1 = x0 only read the CSR
+    bool isWrite = (funct3 == 0b001) || (rs1 != 0);
+    uint32_t rs1Data = rf->read(rs1); // Read before rd may overwrite it
+
+    if (funct3 > 0b011) {
+        // Immediate CSR Instructions not yet supported
+        return STATUS_OK;
+    }
+
+    if (!csr->isAccessible(csrAddr, isWrite)) {
+        return ILLEGAL_INSTRUCTION;
+    }
+
+    switch (funct3) {
+    case 0b001:	// CSRRW
+        // Write current value of CSR to rd
+        rf->write(csr->readCsr(csrAddr), rd);
+        // Store value of rs1 into CSR
+        csr->writeCsr(csrAddr, rs1Data);
+        break;
+    case 0b010:	// CSRRS
+        // Write current value of CSR to rd
+        rf->write(csr->readCsr(csrAddr), rd);
+        // Use rs1 as a bit mask to set CSR bits
+        if (rs1 != 0)
+            csr->writeCsr(csrAddr, rs1Data | csr->readCsr(csrAddr));
+        break;
+    case 0b011:	// CSRRC
+        // Write current value of CSR to rd
+        rf->write(csr->readCsr(csrAddr), rd);
+        // Usr rs1 as a bit mask to reset CSR bits
+        if (rs1 != 0)
+            csr->writeCsr(csrAddr, (~rs1Data) & csr->readCsr(csrAddr));
+        break;
+    }
+
+    // satp and mstatus writes change how addresses are translated
+    if (isWrite) {
+        if (csr->isPmpCsr(csrAddr)) {
+            mmu->getPmp()->update(csr);
+        }
+        mmu->update(csr);
+    }
+
+    return STATUS_OK;
+}
+
+uint32_t Mcu::loadData(uint32_t vaddr, uint32_t size, uint32_t *readValue) {
+    uint32_t paddr;
+    uint32_t exceptionCode = mmu->translate(vaddr, size, ACCESS_LOAD, &paddr);
+    if (exceptionCode == STATUS_OK) {
+        exceptionCode = bus->read(paddr, size, readValue);
+    }
+
+    if (exceptionCode != STATUS_OK) {
+        trapValue = vaddr;
+    }
+    return exceptionCode;
+}
+
+uint32_t Mcu::storeData(uint32_t vaddr, uint32_t value, uint32_t size) {
+    uint32_t paddr;
+    uint32_t exceptionCode = mmu->translate(vaddr, size, ACCESS_STORE, &paddr);
+    if (exceptionCode == STATUS_OK) {
+        exceptionCode = bus->write(paddr, value, size);
+    }
+
+    if (exceptionCode != STATUS_OK) {
+        trapValue = vaddr;
+    }
+    return exceptionCode;
+}
+
+uint32_t Mcu::executeFloat(uint32_t instruction, uint32_t immediate) {
+    uint32_t opcode = instruction & 0b1111111;
+    uint32_t funct3 = (instruction >> 12) & 0b111;
+    uint32_t rs1 = (instruction >> 15) & 0b11111;
+    uint32_t rs2 = (instruction >> 20) & 0b11111;
+    uint32_t rs3 = (instruction >> 27) & 0b11111;
+    uint32_t rd = (instruction >> 7) & 0b11111;
+    uint32_t exceptionCode;
+    uint32_t readValue;
+    uint32_t result;
+    uint32_t fflags;
+
+    switch (opcode) {
+    case LOAD_FP:
+        if (funct3 != 0b010) {
+            return ILLEGAL_INSTRUCTION; // Only flw without the D extension
+        }
+        exceptionCode = loadData(rf->read(rs1) + immediate, WORD,
+                                 &readValue);
+        if (exceptionCode != STATUS_OK) {
+            return exceptionCode;
+        }
+        frf->write(readValue, rd);
+        return STATUS_OK;
+    case STORE_FP:
+        if (funct3 != 0b010) {
+            return ILLEGAL_INSTRUCTION;
+        }
+        return storeData(rf->read(rs1) + immediate, frf->read(rs2), WORD);
+    default:
+        break;
+    }
+
+    // fcvt.s.w[u] and fmv.w.x take rs1 from the integer register file
+    uint32_t A = FloatingPointUnit::isIntegerSource(instruction)
+                     ? rf->read(rs1)
+                     : frf->read(rs1);
+    exceptionCode = fpu->execute(instruction, A, frf->read(rs2),
+                                 frf->read(rs3), csr->getFrm(), &result,
+                                 &fflags);
+    if (exceptionCode != STATUS_OK) {
+        return exceptionCode;
+    }
+
+    if (FloatingPointUnit::isIntegerDestination(instruction)) {
+        rf->write(result, rd);
+    } else {
+        frf->write(result, rd);
+    }
+    csr->accrueFflags(fflags);
+
+    return STATUS_OK;
+}
+
 void Mcu::debugPreExecute(uint32_t opcode, uint32_t funct3, uint32_t funct7, uint32_t rs1, uint32_t rs2, uint32_t rd, uint32_t immediate, uint32_t csrAddr, uint32_t curInstruction) {
     if (curInstruction == 0) {exit(1);}
     std::cout << std::hex << "Current Instruction: " << curInstruction << std::endl;
@@ -1,3 +1,5 @@
+#include <string.h>
+
 #include "MemoryDevice.h"
 
 MemoryDevice::MemoryDevice(uint32_t baseAddress, uint32_t deviceSize)
@@ -6,7 +8,7 @@ MemoryDevice::MemoryDevice(uint32_t baseAddress, uint32_t deviceSize)
 }
 
 MemoryDevice::~MemoryDevice() {
-    delete mem;
+    delete[] mem;
 }
 
 bool MemoryDevice::checkAlignment(uint32_t addr, uint32_t size) {
@@ -19,6 +21,74 @@ bool MemoryDevice::checkAlignment(uint32_t addr, uint32_t size) {
     return true; // Should never reach hear
 }
 
+void MemoryDevice::saveState(std::vector<uint8_t> &state) {
+    state.assign(mem, mem + deviceSize);
+}
+
+void MemoryDevice::restoreState(const std::vector<uint8_t> &state) {
+    memcpy(mem, state.data(), deviceSize);
+}
+
+uint32_t MemoryDevice::readBlock(uint32_t addr, uint8_t *dst, uint32_t size) {
+    if (!containsBlock(addr, size)) {
+        return LOAD_ACCESS_FAULT;
+    }
+
+    memcpy(dst, getAddress(addr), size);
+    return STATUS_OK;
+}
+
+uint32_t MemoryDevice::writeBlock(uint32_t addr, const uint8_t *src,
+                                  uint32_t size) {
+    if (!containsBlock(addr, size)) {
+        return STORE_ACCESS_FAULT;
+    }
+
+    memcpy(getAddress(addr), src, size);
+    return STATUS_OK;
+}
+
+uint32_t MemoryDevice::atomicOperation(uint32_t addr, uint32_t operation,
+                                       uint32_t operand,
+                                       uint32_t *readValue) {
+    uint32_t exceptionCode = read(addr, WORD, readValue);
+    if (exceptionCode != STATUS_OK) {
+        return exceptionCode;
+    }
+
+    return write(addr, calculateAtomic(operation, *readValue, operand), WORD);
+}
+
+uint32_t MemoryDevice::compareAndSwap(uint32_t addr, uint32_t expected,
+                                      uint32_t value, bool *isSwapped) {
+    uint32_t current;
+    uint32_t exceptionCode = read(addr, WORD, &current);
+    if (exceptionCode != STATUS_OK) {
+        return exceptionCode;
+    }
+
+    *isSwapped = (current == expected);
+    return *isSwapped ? write(addr, value, WORD) : STATUS_OK;
+}
+
+uint32_t MemoryDevice::calculateAtomic(uint32_t operation, uint32_t current,
+                                       uint32_t operand) {
+    switch (operation) {
+    case AMO_ADD: return current + operand;
+    case AMO_SWAP: return operand;
+    case AMO_XOR: return current ^ operand;
+    case AMO_OR: return current | operand;
+    case AMO_AND: return current & operand;
+    case AMO_MIN:
+        return ((int32_t)current < (int32_t)operand) ? current : operand;
+    case AMO_MAX:
+        return ((int32_t)current > (int32_t)operand) ? current : operand;
+    case AMO_MINU: return (current < operand) ? current : operand;
+    case AMO_MAXU: return (current > operand) ? current : operand;
+    default: return current;
+    }
+}
+
 uint8_t *MemoryDevice::getAddress(uint32_t addr) {
     uint32_t addr_offset = addr - baseAddress;
     return (uint8_t *)(mem + addr_offset);
@@ -0,0 +1,200 @@
+#include "Mmu.h"
+
+// No Sv32 VPN has bits above 19 set
+#define TLB_INVALID_VPN             0xffffffff
+
+Mmu::Mmu(Bus *bus) : bus(bus), asid(0), rootPpn(0),
+                     permissionKey(0xffffffff) {
+    pmp = new Pmp();
+
+    for (uint32_t accessType = 0; accessType < ACCESS_TYPES; accessType++) {
+        isTranslated[accessType] = false;
+        isMachineAccess[accessType] = true;
+    }
+
+    flush(0, 0, true, true);
+    resetTlbCounters();
+    buildPermissions(MACHINE_MODE, MACHINE_MODE, false, false);
+}
+
+Mmu::~Mmu() {
+    delete pmp;
+}
+
+void Mmu::update(Csr *csr) {
+    uint32_t satp = csr->readCsr(CSR_SATP);
+    uint32_t mstatus = csr->readCsr(CSR_MSTATUS);
+    uint32_t fetchPrivilege = csr->getPrivilegeLevel();
+    uint32_t dataPrivilege = fetchPrivilege;
+    bool isPaging = (satp >> SATP_MODE_MASK) & 0b1;
+
+    // MPRV makes M-mode loads and stores use the privilege level in MPP
+    if (fetchPrivilege == MACHINE_MODE &&
+        ((mstatus >> MSTATUS_MPRV_MASK) & 0b1)) {
+        dataPrivilege = csr->getMpp();
+    }
+
+    isTranslated[ACCESS_FETCH] = isPaging && fetchPrivilege != MACHINE_MODE;
+    isTranslated[ACCESS_LOAD] = isPaging && dataPrivilege != MACHINE_MODE;
+    isTranslated[ACCESS_STORE] = isTranslated[ACCESS_LOAD];
+    isMachineAccess[ACCESS_FETCH] = fetchPrivilege == MACHINE_MODE;
+    isMachineAccess[ACCESS_LOAD] = dataPrivilege == MACHINE_MODE;
+    isMachineAccess[ACCESS_STORE] = isMachineAccess[ACCESS_LOAD];
+    asid = (satp >> SATP_ASID_MASK) & SATP_ASID_BITS;
+    rootPpn = satp & SATP_PPN_BITS;
+
+    buildPermissions(fetchPrivilege, dataPrivilege,
+                     (mstatus >> MSTATUS_SUM_MASK) & 0b1,
+                     (mstatus >> MSTATUS_MXR_MASK) & 0b1);
+}
+
+void Mmu::flush(uint32_t vaddr, uint32_t asid, bool isAllAddresses,
+                bool isAllAsids) {
+    uint32_t vpn = vaddr >> PAGE_SHIFT;
+
+    for (uint32_t accessType = 0; accessType < ACCESS_TYPES; accessType++) {
+        for (TlbEntry &entry : tlb[accessType]) {
+            // Global mappings survive flushes of a single address space
+            bool isAsidMatch = isAllAsids ||
+                               (entry.asid == asid && !(entry.flags & PTE_G));
+            if ((isAllAddresses || entry.vpn == vpn) && isAsidMatch) {
+                entry.vpn = TLB_INVALID_VPN;
+            }
+        }
+    }
+}
+
+Pmp *Mmu::getPmp() {
+    return pmp;
+}
+
+uint64_t Mmu::getTlbHits(uint32_t accessType) {
+    return hits[accessType];
+}
+
+uint64_t Mmu::getTlbMisses(uint32_t accessType) {
+    return misses[accessType];
+}
+
+void Mmu::resetTlbCounters() {
+    for (uint32_t accessType = 0; accessType < ACCESS_TYPES; accessType++) {
+        hits[accessType] = 0;
+        misses[accessType] = 0;
+    }
+}
+
+uint32_t Mmu::walk(uint32_t vaddr, uint32_t accessType, uint32_t *paddr) {
+    uint32_t vpn[2] = {(vaddr >> 12) & 0x3ff, (vaddr >> 22) & 0x3ff};
+    uint32_t tableAddr = rootPpn << PAGE_SHIFT;
+    uint32_t pteAddr;
+    uint32_t pte;
+    int level;
+
+    for (level = 1; ; level--) {
+        // Page table accesses are checked as S-mode loads
+        pteAddr = tableAddr + vpn[level] * 4;
+        if (!pmp->isAllowed(pteAddr, WORD, ACCESS_LOAD, false) ||
+            bus->read(pteAddr, WORD, &pte) != STATUS_OK) {
+            return getAccessFault(accessType);
+        }
+
+        // Invalid entry, or reserved write-only encoding
+        if (!(pte & PTE_V) || (!(pte & PTE_R) && (pte & PTE_W))) {
+            return getPageFault(accessType);
+        }
+
+        if (pte & (PTE_R | PTE_X)) {
+            break; // Leaf
+        }
+
+        if (level == 0) {
+            return getPageFault(accessType);
+        }
+        tableAddr = (pte >> 10) << PAGE_SHIFT;
+    }
+
+    // The accessed/dirty bits are set below, they do not fault
+    if (!isPermitted[accessType][(pte | PTE_A | PTE_D) & 0xff]) {
+        return getPageFault(accessType);
+    }
+
+    // Megapages must be aligned to 4 MiB
+    uint32_t ppn = pte >> 10;
+    if (level == 1) {
+        if (ppn & 0x3ff) {
+            return getPageFault(accessType);
+        }
+        ppn |= vpn[0];
+    }
+
+    // Set the accessed/dirty bits. Another hart may update the entry at
+    // the same time, in which case the walk is repeated
+    uint32_t updated = pte | PTE_A | ((accessType == ACCESS_STORE) ? PTE_D : 0);
+    if (updated != pte) {
+        bool isSwapped;
+        if (bus->compareAndSwap(pteAddr, pte, updated, &isSwapped) !=
+            STATUS_OK) {
+            return getAccessFault(accessType);
+        }
+        if (!isSwapped) {
+            return walk(vaddr, accessType, paddr);
+        }
+    }
+
+    TlbEntry &entry = tlb[accessType][(vaddr >> PAGE_SHIFT) % TLB_ENTRIES];
+    entry.vpn = vaddr >> PAGE_SHIFT;
+    entry.ppn = ppn;
+    entry.asid = asid;
+    entry.flags = updated & 0xff;
+
+    *paddr = ppn << PAGE_SHIFT | (vaddr & (PAGE_SIZE - 1));
+    return STATUS_OK;
+}
+
+void Mmu::buildPermissions(uint32_t fetchPrivilege, uint32_t dataPrivilege,
+                           bool isSum, bool isMxr) {
+    uint32_t key = (fetchPrivilege << 4) | (dataPrivilege << 2) |
+                   (isSum << 1) | isMxr;
+    if (key == permissionKey) {
+        return;
+    }
+    permissionKey = key;
+
+    for (uint32_t flags = 0; flags < 256; flags++) {
+        bool isUserPage = flags & PTE_U;
+        bool isReadable = (flags & PTE_R) || (isMxr && (flags & PTE_X));
+
+        // U-mode only accesses user pages. S-mode never executes them and
+        // only loads/stores them when SUM is set
+        bool isFetchAllowed = (fetchPrivilege == USER_MODE) ? isUserPage
+                                                            : !isUserPage;
+        bool isDataAllowed = (dataPrivilege == USER_MODE)
+                                 ? isUserPage
+                                 : (!isUserPage || isSum);
+
+        // A TLB hit also requires the accessed/dirty bits the walk sets
+        isPermitted[ACCESS_FETCH][flags] =
+            isFetchAllowed && (flags & PTE_X) && (flags & PTE_A);
+        isPermitted[ACCESS_LOAD][flags] =
+            isDataAllowed && isReadable && (flags & PTE_A);
+        isPermitted[ACCESS_STORE][flags] =
+            isDataAllowed && (flags & PTE_W) && (flags & PTE_A) &&
+            (flags & PTE_D);
+    }
+}
+
+uint32_t Mmu::getPageFault(uint32_t accessType) {
+    switch (accessType) {
+    case ACCESS_FETCH: return INSTRUCTION_PAGE_FAULT;
+    case ACCESS_LOAD: return LOAD_PAGE_FAULT;
+    default: return STORE_PAGE_FAULT;
+    }
+}
+
+uint32_t Mmu::getAccessFault(uint32_t accessType) {
+    switch (accessType) {
+    case ACCESS_FETCH: return INSTRUCTION_ACCESS_FAULT;
+    case ACCESS_LOAD: return LOAD_ACCESS_FAULT;
+    default: return STORE_ACCESS_FAULT;
+    }
+}
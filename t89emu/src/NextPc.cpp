@@ -12,30 +12,32 @@ NextPc::~NextPc() {
 
 uint32_t NextPc::calculateNextPc(uint32_t offset, uint32_t opcode,
                                  uint32_t funct3, uint32_t A, uint32_t B,
-                                 uint32_t mepc) {
+                                 uint32_t epc, uint32_t length) {
     switch (opcode) {
     case JAL:
         nextPc += offset;
         break;  // JAL signal
     case JALR:
-        nextPc = A + offset;
+        nextPc = (A + offset) & ~0x1;
         break;  // JALR signal
     case BTYPE:
-        nextPc += branchAlu(A, B, funct3) ? offset : 4;
+        nextPc += branchAlu(A, B, funct3) ? offset : length;
         break;  // B-type signal
     case PRIV:
-        if ((funct3 == 0) && (offset == MRET_IMM)) {  // MRET
-            nextPc = mepc;
+        if ((funct3 == 0) &&
+            (offset == MRET_IMM || offset == SRET_IMM)) {  // MRET / SRET
+            nextPc = epc;
         } else {  // CSR Instruction
-            nextPc += 4;
+            nextPc += length;
         }
         break;
     default:
-        nextPc += 4;
+        nextPc += length;
         break;  // All other instructions
     }
 
-    if (nextPc % 4 != 0) {
+    // Compressed instructions only need halfword alignment
+    if (nextPc % 2 != 0) {
         return INSTRUCTION_ADDRESS_MISALIGNED;
     }
 
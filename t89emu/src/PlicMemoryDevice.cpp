@@ -0,0 +1,79 @@
+#include "PlicMemoryDevice.h"
+
+PlicMemoryDevice::PlicMemoryDevice(uint32_t base, uint32_t size)
+    : MemoryDevice::MemoryDevice(base, size) {
+    
+}
+
+uint32_t PlicMemoryDevice::read(uint32_t addr, uint32_t size,
+                                uint32_t *read_value) {
+    // Registers are only accessible as words
+    if (!checkAlignment(addr, size) || size != WORD) {
+        return LOAD_ADDRESS_MISALIGNED;
+    }
+
+    if (addr - baseAddress == PLIC_CLAIM_OFFSET) {
+        *read_value = claimInterrupt();
+    } else {
+        *read_value =
+            __atomic_load_n((uint32_t *)getAddress(addr), __ATOMIC_RELAXED);
+    }
+
+    return STATUS_OK;
+}
+
+uint32_t PlicMemoryDevice::write(uint32_t addr, uint32_t value,
+                                 uint32_t size) {
+    if (!checkAlignment(addr, size) || size != WORD) {
+        return STORE_ADDRESS_MISALIGNED;
+    }
+
+    switch (addr - baseAddress) {
+    case PLIC_ENABLE_OFFSET:
+        // Source 0 can never be enabled
+        __atomic_store_n((uint32_t *)getAddress(addr), value & ~0x1,
+                         __ATOMIC_RELAXED);
+        break;
+    case PLIC_PENDING_OFFSET: // Pending bits are read only
+    case PLIC_CLAIM_OFFSET: // Sources are edge triggered, nothing to complete
+    default:
+        break;
+    }
+
+    return STATUS_OK;
+}
+
+void PlicMemoryDevice::raiseInterrupt(uint32_t source) {
+    if (source == 0 || source >= PLIC_NUM_SOURCES) {
+        return;
+    }
+
+    // Sources may be raised while another hart claims
+    uint32_t *pending = (uint32_t *)&mem[PLIC_PENDING_OFFSET];
+    __atomic_fetch_or(pending, 1 << source, __ATOMIC_RELAXED);
+}
+
+void PlicMemoryDevice::nextCycle(Csr *csr) {
+    uint32_t *pending = (uint32_t *)&mem[PLIC_PENDING_OFFSET];
+    uint32_t *enable = (uint32_t *)&mem[PLIC_ENABLE_OFFSET];
+
+    if (__atomic_load_n(pending, __ATOMIC_RELAXED) &
+        __atomic_load_n(enable, __ATOMIC_RELAXED)) csr->setMeip();
+    else csr->resetMeip();
+}
+
+uint32_t PlicMemoryDevice::claimInterrupt() {
+    uint32_t *pending = (uint32_t *)&mem[PLIC_PENDING_OFFSET];
+    uint32_t *enable = (uint32_t *)&mem[PLIC_ENABLE_OFFSET];
+
+    uint32_t active = __atomic_load_n(pending, __ATOMIC_RELAXED) & *enable;
+    if (!active) {
+        return 0;
+    }
+
+    // Lowest source id has the highest priority
+    uint32_t source = __builtin_ctz(active);
+    __atomic_fetch_and(pending, ~(1 << source), __ATOMIC_RELAXED);
+
+    return source;
+}
@@ -0,0 +1,120 @@
+#include <algorithm>
+
+#include "Mmu.h"
+#include "Pmp.h"
+
+Pmp::Pmp() : isEnabled(false) {
+    for (uint32_t i = 0; i < PMP_ENTRIES; i++) {
+        regions[i] = {0, 0, 0};
+    }
+}
+
+Pmp::~Pmp() {
+
+}
+
+void Pmp::update(Csr *csr) {
+    isEnabled = false;
+    for (uint32_t i = 0; i < PMP_ENTRIES; i++) {
+        uint32_t cfg = csr->getPmpcfg(i);
+        uint64_t pmpaddr = csr->readCsr(CSR_PMPADDR0 + i);
+        Region &region = regions[i];
+        region = {0, 0, cfg};
+
+        switch ((cfg >> PMP_A_MASK) & 0b11) {
+        case PMP_A_TOR:
+            // The previous pmpaddr is the base, 0 for the first entry
+            if (i > 0) {
+                region.start =
+                    (uint64_t)csr->readCsr(CSR_PMPADDR0 + i - 1) << 2;
+            }
+            region.end = std::max(region.start, pmpaddr << 2);
+            break;
+        case PMP_A_NA4:
+            region.start = pmpaddr << 2;
+            region.end = region.start + 4;
+            break;
+        case PMP_A_NAPOT: {
+            // The number of trailing ones encodes the size
+            uint32_t ones = 0;
+            while (ones < 32 && ((pmpaddr >> ones) & 0b1)) {
+                ones++;
+            }
+            uint64_t size = (uint64_t)1 << (ones + 3);
+            region.start = (pmpaddr << 2) & ~(size - 1);
+            region.end = region.start + size;
+            break;
+        }
+        default: // OFF
+            continue;
+        }
+
+        // Only 32-bit physical addresses exist
+        region.start = std::min(region.start, (uint64_t)1 << 32);
+        region.end = std::min(region.end, (uint64_t)1 << 32);
+        isEnabled = true;
+    }
+
+    if (!isEnabled) {
+        return;
+    }
+
+    // Unmatched pages: M-mode has full access, S/U-mode none
+    pages.assign(PMP_PAGES, 0b111 << PMP_PAGE_MACHINE_SHIFT);
+
+    // Paint from the lowest priority entry so higher priorities win
+    for (int i = PMP_ENTRIES - 1; i >= 0; i--) {
+        const Region &region = regions[i];
+        if (region.start >= region.end) {
+            continue;
+        }
+
+        uint64_t firstPage = region.start >> 12;
+        uint64_t lastPage = (region.end - 1) >> 12;
+        std::fill(pages.begin() + firstPage, pages.begin() + lastPage + 1,
+                  getPagePermissions(region.cfg));
+
+        // Partly covered pages need the exact check
+        if (region.start & 0xfff) {
+            pages[firstPage] = PMP_PAGE_PARTIAL;
+        }
+        if (region.end & 0xfff) {
+            pages[lastPage] = PMP_PAGE_PARTIAL;
+        }
+    }
+}
+
+bool Pmp::isAllowedByEntries(uint32_t paddr, uint32_t size,
+                             uint32_t accessType, bool isMachine) {
+    uint64_t start = paddr;
+    uint64_t end = start + size;
+
+    for (uint32_t i = 0; i < PMP_ENTRIES; i++) {
+        const Region &region = regions[i];
+        if (end <= region.start || start >= region.end) {
+            continue;
+        }
+
+        // An access only partly inside the highest priority match fails
+        if (start < region.start || end > region.end) {
+            return false;
+        }
+
+        uint32_t permissions = getPagePermissions(region.cfg);
+        return (permissions >> (accessType +
+                (isMachine ? PMP_PAGE_MACHINE_SHIFT : 0))) & 0b1;
+    }
+
+    return isMachine;
+}
+
+uint8_t Pmp::getPagePermissions(uint32_t cfg) {
+    uint8_t permissions = 0;
+    if (cfg & PMP_X) permissions |= 1 << ACCESS_FETCH;
+    if (cfg & PMP_R) permissions |= 1 << ACCESS_LOAD;
+    if (cfg & PMP_W) permissions |= 1 << ACCESS_STORE;
+
+    // M-mode is only bound by locked entries
+    uint8_t machinePermissions = (cfg & PMP_L) ? permissions : 0b111;
+    return permissions | (machinePermissions << PMP_PAGE_MACHINE_SHIFT);
+}
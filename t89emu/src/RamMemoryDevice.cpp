@@ -3,7 +3,9 @@
 #include <iostream>
 
 RamMemoryDevice::RamMemoryDevice(uint32_t base, uint32_t size)
-    : MemoryDevice::MemoryDevice(base, size) {
+    : MemoryDevice::MemoryDevice(base, size),
+      codePages((size + CODE_PAGE_SIZE - 1) >> CODE_PAGE_SHIFT, 0),
+      pageVersions(codePages.size(), 0) {
     
 }
 
@@ -14,10 +16,17 @@ uint32_t RamMemoryDevice::read(uint32_t addr, uint32_t size,
         return LOAD_ADDRESS_MISALIGNED;
     }
 
+    // Harts on other host threads may access the same location. Relaxed
+    // atomics compile to plain moves, ordering comes from FENCE and AMOs
+    uint8_t *data = getAddress(addr);
     switch (size) {
-    case BYTE: *readValue = *((uint8_t *)getAddress(addr));
-    case HALFWORD: *readValue = *((uint16_t *)getAddress(addr));
-    case WORD: *readValue = *((uint32_t *)getAddress(addr));
+    case BYTE: *readValue = __atomic_load_n(data, __ATOMIC_RELAXED); break;
+    case HALFWORD:
+        *readValue = __atomic_load_n((uint16_t *)data, __ATOMIC_RELAXED);
+        break;
+    case WORD:
+        *readValue = __atomic_load_n((uint32_t *)data, __ATOMIC_RELAXED);
+        break;
     }
 
     return STATUS_OK;
@@ -30,11 +39,93 @@ uint32_t RamMemoryDevice::write(uint32_t addr, uint32_t writeValue,
         return STORE_ADDRESS_MISALIGNED;
     }
 
+    uint8_t *data = getAddress(addr);
     switch (size) {
-    case BYTE: *((uint8_t *)getAddress(addr)) = writeValue; break;
-    case HALFWORD: *((uint16_t *)getAddress(addr)) = writeValue; break;
-    case WORD : *((uint32_t *)getAddress(addr)) = writeValue; break;
+    case BYTE: __atomic_store_n(data, writeValue, __ATOMIC_RELAXED); break;
+    case HALFWORD:
+        __atomic_store_n((uint16_t *)data, writeValue, __ATOMIC_RELAXED);
+        break;
+    case WORD:
+        __atomic_store_n((uint32_t *)data, writeValue, __ATOMIC_RELAXED);
+        break;
     }
+    checkCodePage(addr);
     
+    return STATUS_OK;
+}
+
+uint32_t RamMemoryDevice::writeBlock(uint32_t addr, const uint8_t *src,
+                                     uint32_t size) {
+    uint32_t exceptionCode = MemoryDevice::writeBlock(addr, src, size);
+    if (exceptionCode != STATUS_OK || size == 0) {
+        return exceptionCode;
+    }
+
+    // Check every page the block touches
+    uint32_t firstPage = (addr - baseAddress) >> CODE_PAGE_SHIFT;
+    uint32_t lastPage = (addr - baseAddress + size - 1) >> CODE_PAGE_SHIFT;
+    for (uint32_t page = firstPage; page <= lastPage; page++) {
+        checkCodePage(baseAddress + (page << CODE_PAGE_SHIFT));
+    }
+
+    return STATUS_OK;
+}
+
+void RamMemoryDevice::restoreState(const std::vector<uint8_t> &state) {
+    writeBlock(baseAddress, state.data(), deviceSize);
+}
+
+uint32_t RamMemoryDevice::atomicOperation(uint32_t addr, uint32_t operation,
+                                          uint32_t operand,
+                                          uint32_t *readValue) {
+    if (!checkAlignment(addr, WORD)) {
+        return STORE_ADDRESS_MISALIGNED;
+    }
+
+    uint32_t *word = (uint32_t *)getAddress(addr);
+    uint32_t current;
+    switch (operation) {
+    case AMO_ADD:
+        *readValue = __atomic_fetch_add(word, operand, __ATOMIC_SEQ_CST);
+        break;
+    case AMO_SWAP:
+        *readValue = __atomic_exchange_n(word, operand, __ATOMIC_SEQ_CST);
+        break;
+    case AMO_XOR:
+        *readValue = __atomic_fetch_xor(word, operand, __ATOMIC_SEQ_CST);
+        break;
+    case AMO_OR:
+        *readValue = __atomic_fetch_or(word, operand, __ATOMIC_SEQ_CST);
+        break;
+    case AMO_AND:
+        *readValue = __atomic_fetch_and(word, operand, __ATOMIC_SEQ_CST);
+        break;
+    default: // min/max have no host instruction, retry until unchanged
+        current = __atomic_load_n(word, __ATOMIC_SEQ_CST);
+        while (!__atomic_compare_exchange_n(
+            word, &current, calculateAtomic(operation, current, operand),
+            false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+        }
+        *readValue = current;
+        break;
+    }
+    checkCodePage(addr);
+
+    return STATUS_OK;
+}
+
+uint32_t RamMemoryDevice::compareAndSwap(uint32_t addr, uint32_t expected,
+                                         uint32_t value, bool *isSwapped) {
+    if (!checkAlignment(addr, WORD)) {
+        return STORE_ADDRESS_MISALIGNED;
+    }
+
+    *isSwapped = __atomic_compare_exchange_n((uint32_t *)getAddress(addr),
+                                             &expected, value, false,
+                                             __ATOMIC_SEQ_CST,
+                                             __ATOMIC_SEQ_CST);
+    if (*isSwapped) {
+        checkCodePage(addr);
+    }
     return STATUS_OK;
 }
\ No newline at end of file
@@ -15,9 +15,9 @@ uint32_t RomMemoryDevice::read(uint32_t addr, uint32_t size,
     }
 
     switch (size) {
-    case BYTE: *readValue = *((uint8_t *)getAddress(addr));
-    case HALFWORD: *readValue = *((uint16_t *)getAddress(addr));
-    case WORD: *readValue = *((uint32_t *)getAddress(addr));
+    case BYTE: *readValue = *((uint8_t *)getAddress(addr)); break;
+    case HALFWORD: *readValue = *((uint16_t *)getAddress(addr)); break;
+    case WORD: *readValue = *((uint32_t *)getAddress(addr)); break;
     }
     
     return STATUS_OK;
@@ -27,4 +27,10 @@ uint32_t RomMemoryDevice::write(uint32_t addr, uint32_t writeValue,
                                 uint32_t size) {
     // Cannot write to read only memory, throw exception
     return ILLEGAL_INSTRUCTION;
+}
+
+uint32_t RomMemoryDevice::writeBlock(uint32_t addr, const uint8_t *src,
+                                     uint32_t size) {
+    // DMA into read only memory is not permitted
+    return STORE_ACCESS_FAULT;
 }
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "Runner.h"
+
+Runner::Runner(Smp *smp, const RunOptions &options)
+    : smp(smp), options(options) {
+
+}
+
+RunResult Runner::run() {
+    RunResult result;
+    uint32_t numHarts = smp->getNumHarts();
+    auto start = std::chrono::steady_clock::now();
+
+    if (numHarts == 1) {
+        uint64_t count = 0;
+        result.reason = runSingleHart(&count);
+        result.hartInstructions.push_back(count);
+    } else {
+        // Smp counts include earlier runs
+        std::vector<uint64_t> startCounts;
+        for (uint32_t hartId = 0; hartId < numHarts; hartId++) {
+            startCounts.push_back(smp->getInstructionCount(hartId));
+        }
+        result.reason = runMultipleHarts();
+        for (uint32_t hartId = 0; hartId < numHarts; hartId++) {
+            result.hartInstructions.push_back(
+                smp->getInstructionCount(hartId) - startCounts[hartId]);
+        }
+    }
+
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    result.seconds = elapsed.count();
+    result.instructions = 0;
+    for (uint64_t count : result.hartInstructions) {
+        result.instructions += count;
+    }
+
+    return result;
+}
+
+const char *Runner::runSingleHart(uint64_t *instructions) {
+    Mcu *mcu = smp->getHart(0);
+    ProgramCounter *pc = mcu->getProgramCounterModule();
+    SemihostMemoryDevice *semihost = mcu->getSemihostDevice();
+    auto start = std::chrono::steady_clock::now();
+    uint64_t count = 0;
+
+    while (!options.maxInstructions || count < options.maxInstructions) {
+        uint64_t chunk = RUNNER_CHECK_INTERVAL;
+        if (options.maxInstructions &&
+            options.maxInstructions - count < chunk) {
+            chunk = options.maxInstructions - count;
+        }
+
+        for (uint64_t i = 0; i < chunk; i++) {
+            uint32_t lastPc = pc->getPc();
+            mcu->nextInstruction();
+            count++;
+
+            uint32_t curPc = pc->getPc();
+            if (semihost->hasExited()) {
+                *instructions = count;
+                return RUN_GUEST_EXIT;
+            }
+            if (options.hasHaltAddress && curPc == options.haltAddress) {
+                *instructions = count;
+                return RUN_HALT_ADDRESS;
+            }
+            if (options.isHaltOnLoop && curPc == lastPc) {
+                *instructions = count;
+                return RUN_JUMP_TO_SELF;
+            }
+        }
+
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+        if (options.maxSeconds && elapsed.count() >= options.maxSeconds) {
+            *instructions = count;
+            return RUN_TIME_LIMIT;
+        }
+    }
+
+    *instructions = count;
+    return RUN_INSTRUCTION_LIMIT;
+}
+
+const char *Runner::runMultipleHarts() {
+    SemihostMemoryDevice *semihost = smp->getHart(0)->getSemihostDevice();
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::duration<double>(options.maxSeconds);
+    bool isTimedOut = false;
+
+    auto isPastDeadline = [&]() {
+        return options.maxSeconds &&
+               std::chrono::steady_clock::now() >= deadline;
+    };
+
+    if (options.quantum) {
+        // Exits, halt conditions and the wall-clock limit are all checked
+        // on the run's own thread, so the run ends on the same instruction
+        // every time and no stop request can race with its start
+        HaltConditions halt;
+        halt.hasHaltAddress = options.hasHaltAddress;
+        halt.haltAddress = options.haltAddress;
+        halt.isHaltOnLoop = options.isHaltOnLoop;
+        halt.maxSeconds = options.maxSeconds;
+        uint32_t reason = smp->runInterleaved(options.maxInstructions,
+                                              options.quantum, halt);
+
+        switch (reason) {
+        case SMP_STOP_EXIT: return RUN_GUEST_EXIT;
+        case SMP_STOP_HALT_ADDRESS: return RUN_HALT_ADDRESS;
+        case SMP_STOP_JUMP_TO_SELF: return RUN_JUMP_TO_SELF;
+        case SMP_STOP_TIME_LIMIT: return RUN_TIME_LIMIT;
+        case SMP_STOP_REQUESTED: return RUN_TIME_LIMIT;
+        default: return RUN_INSTRUCTION_LIMIT;
+        }
+    }
+
+    // Free running threads, exits and the wall-clock limit are polled
+    smp->start(options.maxInstructions);
+    while (smp->isRunning()) {
+        if (semihost->hasExited()) {
+            break;
+        }
+        if (isPastDeadline()) {
+            isTimedOut = true;
+            break;
+        }
+        std::this_thread::sleep_for(
+            std::chrono::milliseconds(RUNNER_POLL_MS));
+    }
+    smp->stop();
+
+    if (semihost->hasExited()) {
+        return RUN_GUEST_EXIT;
+    }
+    return isTimedOut ? RUN_TIME_LIMIT : RUN_INSTRUCTION_LIMIT;
+}
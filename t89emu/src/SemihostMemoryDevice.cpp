@@ -0,0 +1,134 @@
+#include "SemihostMemoryDevice.h"
+#include "InputLog.h"
+
+#include <cstdio>
+
+SemihostMemoryDevice::SemihostMemoryDevice(uint32_t base, uint32_t size,
+                                           Bus *bus)
+    : MemoryDevice::MemoryDevice(base, size), isExited(false), exitCode(0),
+      startTime(std::chrono::steady_clock::now()), inputLog(nullptr),
+      capturedOutput(nullptr), bus(bus) {
+
+}
+
+uint32_t SemihostMemoryDevice::read(uint32_t addr, uint32_t size,
+                                    uint32_t *readValue) {
+    // Registers are only accessible as words
+    if (!checkAlignment(addr, size) || size != WORD) {
+        return LOAD_ADDRESS_MISALIGNED;
+    }
+
+    *readValue = *((uint32_t *)getAddress(addr));
+
+    return STATUS_OK;
+}
+
+uint32_t SemihostMemoryDevice::write(uint32_t addr, uint32_t value,
+                                     uint32_t size) {
+    if (!checkAlignment(addr, size) || size != WORD) {
+        return STORE_ADDRESS_MISALIGNED;
+    }
+
+    uint32_t offset = addr - baseAddress;
+    if (offset >= SEMIHOST_RESULT_OFFSET) { // Results are read only
+        return STATUS_OK;
+    } else if (offset != SEMIHOST_COMMAND_OFFSET) {
+        *((uint32_t *)getAddress(addr)) = value;
+        return STATUS_OK;
+    }
+
+    uint32_t *args = (uint32_t *)&mem[SEMIHOST_ARG0_OFFSET];
+    std::chrono::nanoseconds elapsed;
+    switch (value) {
+    case SEMIHOST_EXIT:
+        exitCode = args[0];
+        fflush(stdout);
+        fflush(stderr);
+        isExited.store(true, std::memory_order_relaxed);
+        setResult(0);
+        break;
+    case SEMIHOST_WRITE:
+        setResult(writeHost(args[0], args[1], args[2]));
+        break;
+    case SEMIHOST_TIME:
+        elapsed = std::chrono::steady_clock::now() - startTime;
+        setResult(inputLog ? inputLog->readTime(elapsed.count())
+                           : elapsed.count());
+        break;
+    default:
+        setResult(SEMIHOST_ERROR);
+        break;
+    }
+
+    return STATUS_OK;
+}
+
+uint32_t SemihostMemoryDevice::getExitCode() {
+    return exitCode;
+}
+
+void SemihostMemoryDevice::saveState(std::vector<uint8_t> &state) {
+    MemoryDevice::saveState(state);
+    appendState(state, (bool)isExited);
+    appendState(state, exitCode);
+}
+
+void SemihostMemoryDevice::restoreState(const std::vector<uint8_t> &state) {
+    MemoryDevice::restoreState(state);
+    size_t offset = deviceSize;
+    bool hasExitedState;
+    loadState(state, &offset, &hasExitedState);
+    loadState(state, &offset, &exitCode);
+    isExited.store(hasExitedState, std::memory_order_relaxed);
+}
+
+void SemihostMemoryDevice::captureOutput(std::string *output) {
+    std::lock_guard<std::mutex> lock(captureLock);
+    capturedOutput = output;
+}
+
+void SemihostMemoryDevice::setInputLog(InputLog *log) {
+    inputLog = log;
+}
+
+uint32_t SemihostMemoryDevice::writeHost(uint32_t fd, uint32_t buf,
+                                         uint32_t len) {
+    FILE *file;
+    switch (fd) {
+    case 1: file = stdout; break;
+    case 2: file = stderr; break;
+    default: return SEMIHOST_ERROR;
+    }
+
+    // Copy out of guest memory in chunks, stopping at the first fault
+    uint8_t chunk[SEMIHOST_CHUNK_SIZE];
+    uint32_t written = 0;
+    while (written < len) {
+        uint32_t chunkSize = len - written;
+        if (chunkSize > SEMIHOST_CHUNK_SIZE) {
+            chunkSize = SEMIHOST_CHUNK_SIZE;
+        }
+        if (bus->readBlock(buf + written, chunk, chunkSize) != STATUS_OK) {
+            break;
+        }
+        std::lock_guard<std::mutex> lock(captureLock);
+        if (capturedOutput) {
+            capturedOutput->append((const char *)chunk, chunkSize);
+            written += chunkSize;
+        } else {
+            // A short write means the host stream failed, stop there
+            size_t hostWritten = fwrite(chunk, 1, chunkSize, file);
+            written += hostWritten;
+            if (hostWritten != chunkSize) {
+                break;
+            }
+        }
+    }
+
+    return (written || !len) ? written : SEMIHOST_ERROR;
+}
+
+void SemihostMemoryDevice::setResult(uint64_t result) {
+    *((uint32_t *)&mem[SEMIHOST_RESULT_OFFSET]) = (uint32_t)result;
+    *((uint32_t *)&mem[SEMIHOST_RESULT_HI_OFFSET]) = (uint32_t)(result >> 32);
+}
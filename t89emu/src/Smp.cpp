@@ -0,0 +1,197 @@
+#include "Smp.h"
+
+Smp::Smp(uint32_t romBase, uint32_t ramBase, uint32_t entryPc,
+         uint32_t numHarts)
+    : instructionCounts(numHarts, 0), isStopping(false), isClockStopped(false),
+      runningHarts(0) {
+    ASSERT(numHarts >= 1 && numHarts <= CLINT_MAX_HARTS,
+           "Smp.cpp: unsupported number of harts\n");
+
+    harts.push_back(new Mcu(romBase, ramBase, entryPc));
+    for (uint32_t hartId = 1; hartId < numHarts; hartId++) {
+        harts.push_back(new Mcu(harts[0], hartId, entryPc));
+    }
+}
+
+Smp::~Smp() {
+    stop();
+
+    // The boot hart owns the shared devices, delete it last
+    for (uint32_t hartId = harts.size() - 1; hartId > 0; hartId--) {
+        delete harts[hartId];
+    }
+    delete harts[0];
+}
+
+void Smp::start(uint64_t maxInstructions) {
+    if (!threads.empty()) {
+        return; // Already running
+    }
+
+    isStopping = false;
+    isClockStopped = false;
+    runningHarts = harts.size();
+    harts[0]->getBusModule()->setSerialized(true);
+
+    for (uint32_t hartId = 0; hartId < harts.size(); hartId++) {
+        threads.emplace_back(&Smp::runHart, this, hartId, maxInstructions);
+    }
+}
+
+uint32_t Smp::runInterleaved(uint64_t maxInstructions, uint32_t quantum,
+                             const HaltConditions &halt) {
+    if (!threads.empty() || quantum == 0) {
+        return SMP_STOP_REQUESTED; // Free running threads own the harts
+    }
+
+    isStopping = false;
+    runningHarts = harts.size();
+    SemihostMemoryDevice *semihost = harts[0]->getSemihostDevice();
+    ProgramCounter *pc = harts[0]->getProgramCounterModule();
+    bool hasHaltCondition = halt.hasHaltAddress || halt.isHaltOnLoop;
+    auto deadline = std::chrono::steady_clock::now() +
+                    std::chrono::duration<double>(halt.maxSeconds);
+    uint64_t lastClockCheck = 0;
+
+    // Exits and halt conditions end the run on the instruction that meets
+    // them, so the number of instructions each hart executed repeats
+    std::vector<uint64_t> executed(harts.size(), 0);
+    uint32_t reason = semihost->hasExited() ? SMP_STOP_EXIT : SMP_STOP_LIMIT;
+    while (reason == SMP_STOP_LIMIT &&
+           (maxInstructions == 0 || executed[0] < maxInstructions)) {
+        if (isStopping.load(std::memory_order_relaxed)) {
+            reason = SMP_STOP_REQUESTED;
+            break;
+        }
+        if (halt.maxSeconds &&
+            executed[0] - lastClockCheck >= SMP_CLOCK_CHECK_INTERVAL) {
+            lastClockCheck = executed[0];
+            if (std::chrono::steady_clock::now() >= deadline) {
+                reason = SMP_STOP_TIME_LIMIT;
+                break;
+            }
+        }
+
+        uint64_t turn = quantum;
+        if (maxInstructions != 0 && maxInstructions - executed[0] < turn) {
+            turn = maxInstructions - executed[0];
+        }
+
+        for (uint32_t hartId = 0;
+             hartId < harts.size() && reason == SMP_STOP_LIMIT; hartId++) {
+            Mcu *hart = harts[hartId];
+
+            // Only hart 0 advances mcycle, so nothing can end the wait of
+            // another hart during its own turn
+            if (hartId != 0 && hart->isIdle()) {
+                executed[hartId] += turn;
+                continue;
+            }
+
+            bool isHaltChecked = hasHaltCondition && hartId == 0;
+            for (uint64_t i = 0; i < turn; i++) {
+                uint32_t lastPc = isHaltChecked ? pc->getPc() : 0;
+                hart->nextInstruction();
+                executed[hartId]++;
+
+                if (semihost->hasExited()) {
+                    reason = SMP_STOP_EXIT;
+                } else if (isHaltChecked) {
+                    uint32_t curPc = pc->getPc();
+                    if (halt.hasHaltAddress && curPc == halt.haltAddress) {
+                        reason = SMP_STOP_HALT_ADDRESS;
+                    } else if (halt.isHaltOnLoop && curPc == lastPc) {
+                        reason = SMP_STOP_JUMP_TO_SELF;
+                    }
+                }
+                if (reason != SMP_STOP_LIMIT) {
+                    break;
+                }
+            }
+        }
+    }
+
+    for (uint32_t hartId = 0; hartId < harts.size(); hartId++) {
+        instructionCounts[hartId] += executed[hartId];
+    }
+    runningHarts = 0;
+    return reason;
+}
+
+void Smp::stop() {
+    isStopping = true;
+    isClockStopped = true;
+    harts[0]->getClintDevice()->wakeAll();
+    join();
+}
+
+void Smp::join() {
+    // Interleaved runs never serialize the bus, and may still be using it
+    // when stopped from another thread
+    if (threads.empty()) {
+        return;
+    }
+
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    threads.clear();
+
+    harts[0]->getBusModule()->setSerialized(false);
+}
+
+bool Smp::isRunning() {
+    return runningHarts > 0;
+}
+
+Mcu *Smp::getHart(uint32_t hartId) {
+    return harts.at(hartId);
+}
+
+uint32_t Smp::getNumHarts() {
+    return harts.size();
+}
+
+uint64_t Smp::getInstructionCount(uint32_t hartId) {
+    return instructionCounts.at(hartId);
+}
+
+void Smp::runHart(uint32_t hartId, uint64_t maxInstructions) {
+    Mcu *hart = harts[hartId];
+    ClintMemoryDevice *clint = hart->getClintDevice();
+    uint64_t count = 0;
+
+    // Stop requests are checked every instruction, a relaxed load is a
+    // plain read on the host
+    while (!isStopping.load(std::memory_order_relaxed) &&
+           (maxInstructions == 0 || count < maxInstructions)) {
+        // Idle harts sleep instead of spinning on WFI. Hart 0 keeps running
+        // idle cycles, it drives mcycle and the devices
+        if (hartId != 0 && hart->isIdle()) {
+            if (isClockStopped) {
+                break;
+            }
+
+            uint64_t cycle = clint->getCycle();
+            clint->waitForInterrupt(hart->getCsrModule(), hartId,
+                                    isClockStopped);
+            uint64_t now = clint->getCycle();
+            uint64_t elapsed = now > cycle ? now - cycle : 0;
+            if (maxInstructions != 0 && elapsed > maxInstructions - count) {
+                elapsed = maxInstructions - count;
+            }
+            count += elapsed;
+            continue;
+        }
+
+        hart->nextInstruction();
+        count++;
+    }
+
+    instructionCounts[hartId] += count;
+    if (hartId == 0) {
+        isClockStopped = true;
+        clint->wakeAll();
+    }
+    runningHarts--;
+}
@@ -11,30 +11,41 @@ Trap::~Trap() {
 }
 
 void Trap::takeTrap(Csr *csr, ProgramCounter *pc, NextPc *nextPc,
-                    uint32_t mcause) {
-    // Save current PC to machine exception program counter
-    csr->setMepc(pc->getPc());
+                    uint32_t mcause, uint32_t tval) {
+    uint32_t privilegeLevel = csr->getPrivilegeLevel();
+    bool isInterrupt = mcause >= 0x80000000;
+    uint32_t cause = mcause & 0x7fffffff;
+    uint32_t delegated =
+        csr->readCsr(isInterrupt ? CSR_MIDELEG : CSR_MEDELEG);
 
-    // If ECALL save PC + 4
-    if (mcause == ECALL_FROM_M_MODE) {
-        csr->setMepc(csr->getMepc() + 4);
+    // Traps below M-mode may be delegated to the supervisor
+    if (privilegeLevel != MACHINE_MODE && ((delegated >> cause) & 0b1)) {
+        takeSupervisorTrap(csr, pc, nextPc, mcause, tval);
+        return;
     }
+
+    // Save current PC to machine exception program counter. For ECALL this
+    // is the ECALL itself at every privilege level, the handler adds 4
+    csr->setMepc(pc->getPc());
     
     // Write cause of exception/interrupt to mcause
     csr->setMcause(mcause);
+    csr->writeCsr(CSR_MTVAL, tval);
 
-    // If MIE was enabled, store in MPIE
+    // Store MIE in MPIE
     if (csr->getMie()) {
         csr->setMpie();
+    } else {
+        csr->resetMpie();
     }
 
     // Globally disable interrupts
     csr->resetMie();
 
     // Save previous privilege level in MPP
-    csr->setMpp(MACHINE_MODE);
-
-    csr->resetMie();   // Globally disable interrupts
+    csr->resetMpp();
+    csr->setMpp(privilegeLevel);
+    csr->setPrivilegeLevel(MACHINE_MODE);
 
     // Set PC to jump to proper interrupt/exception handler in vector table
     uint32_t vectorTableOffset;
@@ -50,4 +61,35 @@ void Trap::takeTrap(Csr *csr, ProgramCounter *pc, NextPc *nextPc,
     nextPc->setNextPc(csr->getMtvec() + 4 * vectorTableOffset);
     pc->setPc(csr->getMtvec() + 4 * vectorTableOffset);
     // printf("trapping to PC: %08x\n", pc->PC);
-}
\ No newline at end of file
+}
+
+void Trap::takeSupervisorTrap(Csr *csr, ProgramCounter *pc, NextPc *nextPc,
+                              uint32_t scause, uint32_t tval) {
+    csr->writeCsr(CSR_SEPC, pc->getPc());
+    csr->writeCsr(CSR_SCAUSE, scause);
+    csr->writeCsr(CSR_STVAL, tval);
+
+    // Store SIE in SPIE and disable supervisor interrupts
+    if (csr->getSie()) {
+        csr->setSpie();
+    } else {
+        csr->resetSpie();
+    }
+    csr->resetSie();
+
+    // Save previous privilege level (U or S) in SPP
+    csr->resetSpp();
+    csr->setSpp(csr->getPrivilegeLevel());
+    csr->setPrivilegeLevel(SUPERVISOR_MODE);
+
+    // stvec follows the standard layout: all traps go to BASE in direct
+    // mode, vectored mode sends interrupts to BASE + 4 * cause
+    uint32_t stvec = csr->readCsr(CSR_STVEC);
+    uint32_t handler = stvec & ~0b11;
+    if ((stvec & 0b11) == 1 && scause >= 0x80000000) {
+        handler += 4 * (scause & 0x7fffffff);
+    }
+
+    nextPc->setNextPc(handler);
+    pc->setPc(handler);
+}
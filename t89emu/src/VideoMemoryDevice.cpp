@@ -1,14 +1,48 @@
+#include <string.h>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 #include "VideoMemoryDevice.h"
 
 VideoMemoryDevice::VideoMemoryDevice(uint32_t base, uint32_t size,
                                      uint32_t gWidth, uint32_t gHeight,
-                                     uint32_t tWidth, uint32_t tHeight)
+                                     uint32_t tWidth, uint32_t tHeight,
+                                     uint32_t numPages, uint32_t vblankCycles,
+                                     EventScheduler *scheduler,
+                                     PlicMemoryDevice *plic, uint32_t irq)
     : MemoryDevice::MemoryDevice(base, size),
       gWidth(gWidth),
       gHeight(gHeight),
       tWidth(tWidth),
-      tHeight(tHeight) {
-    
+      tHeight(tHeight),
+      numPages(numPages),
+      pageSize(gWidth * gHeight * 4),
+      pixelOffset(VIDEO_CONTROLLER_SIZE + tWidth * tHeight),
+      paletteOffset(pixelOffset + numPages * pageSize),
+      rowWords((gHeight + 63) / 64),
+      frame(gWidth * gHeight),
+      presentedPage(0),
+      presentedMode(0),
+      scheduler(scheduler),
+      plic(plic),
+      irq(irq),
+      pendingPage(0),
+      vblankGeneration(0) {
+    mem[VIDEO_NUM_PAGES_OFFSET] = numPages;
+    writeController(VIDEO_VBLANK_CYCLES_OFFSET, vblankCycles);
+
+    // Default palette is RGB332 so indexed mode works without setup
+    uint32_t *palette = (uint32_t *)&mem[paletteOffset];
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t r = ((i >> 5) & 0x7) * 255 / 7;
+        uint32_t g = ((i >> 2) & 0x7) * 255 / 7;
+        uint32_t b = (i & 0x3) * 255 / 3;
+        palette[i] = 0xff000000 | (b << 16) | (g << 8) | r;
+    }
+
+    dirtyRows.resize(numPages * rowWords);
+    markAllDirty();
 }
 
 uint32_t VideoMemoryDevice::read(uint32_t addr, uint32_t size,
@@ -19,9 +53,9 @@ uint32_t VideoMemoryDevice::read(uint32_t addr, uint32_t size,
     }
 
     switch (size) {
-    case BYTE: *readValue = *((uint8_t *)getAddress(addr));
-    case HALFWORD: *readValue = *((uint16_t *)getAddress(addr));
-    case WORD: *readValue = *((uint32_t *)getAddress(addr));
+    case BYTE: *readValue = *((uint8_t *)getAddress(addr)); break;
+    case HALFWORD: *readValue = *((uint16_t *)getAddress(addr)); break;
+    case WORD: *readValue = *((uint32_t *)getAddress(addr)); break;
     }
 
     return STATUS_OK;
@@ -34,15 +68,49 @@ uint32_t VideoMemoryDevice::write(uint32_t addr, uint32_t writeValue,
         return STORE_ADDRESS_MISALIGNED;
     }
 
+    // Controller registers have side effects
+    if (addr - baseAddress < VIDEO_CONTROLLER_SIZE) {
+        return writeController(addr - baseAddress, writeValue);
+    }
+
     switch (size) {
     case BYTE: *((uint8_t *)getAddress(addr)) = writeValue; break;
     case HALFWORD: *((uint16_t *)getAddress(addr)) = writeValue; break;
     case WORD : *((uint32_t *)getAddress(addr)) = writeValue; break;
     }
 
+    markDirty(addr - baseAddress, size);
+
     return STATUS_OK;
 }
 
+uint32_t VideoMemoryDevice::writeBlock(uint32_t addr, const uint8_t *src,
+                                       uint32_t size) {
+    if (!containsBlock(addr, size) ||
+        addr - baseAddress < VIDEO_CONTROLLER_SIZE) {
+        return STORE_ACCESS_FAULT;
+    }
+
+    memcpy(getAddress(addr), src, size);
+    markDirty(addr - baseAddress, size);
+
+    return STATUS_OK;
+}
+
+void VideoMemoryDevice::saveState(std::vector<uint8_t> &state) {
+    MemoryDevice::saveState(state);
+    appendState(state, pendingPage);
+    appendState(state, vblankGeneration);
+}
+
+void VideoMemoryDevice::restoreState(const std::vector<uint8_t> &state) {
+    MemoryDevice::restoreState(state);
+    size_t offset = deviceSize;
+    loadState(state, &offset, &pendingPage);
+    loadState(state, &offset, &vblankGeneration);
+    markAllDirty();
+}
+
 uint32_t VideoMemoryDevice::getGWidth() {
     return gWidth;
 }
@@ -57,4 +125,222 @@ uint32_t VideoMemoryDevice::getTWidth() {
 
 uint32_t VideoMemoryDevice::getTHeight() {
     return tHeight;
-}
\ No newline at end of file
+}
+
+uint8_t *VideoMemoryDevice::getPixelBuffer(uint32_t page) {
+    return mem + pixelOffset + page * pageSize;
+}
+
+uint32_t VideoMemoryDevice::getDisplayPage() {
+    return mem[VIDEO_PAGE_OFFSET];
+}
+
+// A write only affects the register at the written offset
+uint32_t VideoMemoryDevice::writeController(uint32_t offset, uint32_t value) {
+    switch (offset) {
+    case VIDEO_MODE_OFFSET:
+        mem[VIDEO_MODE_OFFSET] = value;
+        markAllDirty(); // Row layout depends on the pixel format
+        break;
+    case VIDEO_PAGE_OFFSET:
+        // Latch the page, the flip happens at the next vblank so the guest
+        // never tears the displayed frame. Without vblanks it happens now
+        if (value >= numPages) {
+            return STORE_ACCESS_FAULT;
+        }
+        pendingPage = value;
+        mem[VIDEO_FLIP_PENDING_OFFSET] = 1;
+        if (!*((uint32_t *)&mem[VIDEO_VBLANK_CYCLES_OFFSET])) {
+            flipPage();
+        }
+        break;
+    case VIDEO_VBLANK_CYCLES_OFFSET:
+        *((uint32_t *)&mem[VIDEO_VBLANK_CYCLES_OFFSET]) = value;
+        vblankGeneration++;
+        if (!value) {
+            flipPage(); // No vblank is coming for a pending flip
+        }
+        scheduleVblank();
+        break;
+    default: // Read only or reserved
+        break;
+    }
+
+    return STATUS_OK;
+}
+
+void VideoMemoryDevice::scheduleVblank() {
+    uint32_t vblankCycles = *((uint32_t *)&mem[VIDEO_VBLANK_CYCLES_OFFSET]);
+    if (!vblankCycles) {
+        return;
+    }
+
+    uint32_t generation = vblankGeneration;
+    scheduler->schedule(scheduler->getCycle() + vblankCycles,
+                        [this, generation]() {
+        if (generation == vblankGeneration) {
+            vblank();
+        }
+    });
+}
+
+void VideoMemoryDevice::flipPage() {
+    if (mem[VIDEO_FLIP_PENDING_OFFSET]) {
+        mem[VIDEO_PAGE_OFFSET] = pendingPage;
+        mem[VIDEO_FLIP_PENDING_OFFSET] = 0;
+    }
+}
+
+void VideoMemoryDevice::vblank() {
+    flipPage();
+
+    (*((uint32_t *)&mem[VIDEO_FRAME_COUNT_OFFSET]))++;
+    plic->raiseInterrupt(irq);
+
+    scheduleVblank();
+}
+
+uint8_t *VideoMemoryDevice::presentFrame(
+    std::vector<std::pair<uint32_t, uint32_t>> &dirtySpans) {
+    uint32_t page = getDisplayPage();
+    uint32_t mode = mem[VIDEO_MODE_OFFSET];
+    uint64_t *dirty = &dirtyRows[page * rowWords];
+
+    // Host copy holds a different page or format, refresh every row
+    if (page != presentedPage || mode != presentedMode) {
+        memset(dirty, 0xff, rowWords * sizeof(uint64_t));
+        presentedPage = page;
+        presentedMode = mode;
+    }
+
+    dirtySpans.clear();
+    for (uint32_t row = 0; row < gHeight; row++) {
+        if (!((dirty[row / 64] >> (row % 64)) & 0x1)) {
+            continue;
+        }
+
+        if (mode != GRAPHICS_MODE) {
+            expandRow(page, row);
+        }
+
+        // Grow the last span or start a new one
+        if (!dirtySpans.empty() &&
+            dirtySpans.back().first + dirtySpans.back().second == row) {
+            dirtySpans.back().second++;
+        } else {
+            dirtySpans.push_back(std::make_pair(row, 1));
+        }
+    }
+    memset(dirty, 0, rowWords * sizeof(uint64_t));
+
+    // 32-bit pages are already in the host format
+    return (mode == GRAPHICS_MODE) ? getPixelBuffer(page)
+                                   : (uint8_t *)frame.data();
+}
+
+bool VideoMemoryDevice::isGraphicsMode(uint32_t mode) {
+    return (mode == GRAPHICS_MODE) || (mode == GRAPHICS_MODE_RGB565) ||
+           (mode == GRAPHICS_MODE_INDEXED);
+}
+
+uint32_t VideoMemoryDevice::getBytesPerPixel() {
+    switch (mem[VIDEO_MODE_OFFSET]) {
+    case GRAPHICS_MODE_RGB565: return 2;
+    case GRAPHICS_MODE_INDEXED: return 1;
+    default: return 4;
+    }
+}
+
+// offset is relative to the device base
+void VideoMemoryDevice::markDirty(uint32_t offset, uint32_t size) {
+    uint32_t end = offset + size;
+    if (end > paletteOffset) { // Palette affects every indexed row
+        if (mem[VIDEO_MODE_OFFSET] == GRAPHICS_MODE_INDEXED) {
+            markAllDirty();
+            return;
+        }
+        end = paletteOffset;
+    }
+
+    if (end <= pixelOffset || offset >= end) {
+        return;
+    }
+    offset = (offset > pixelOffset) ? offset - pixelOffset : 0;
+    end -= pixelOffset;
+
+    uint32_t rowBytes = gWidth * getBytesPerPixel();
+    while (offset < end) {
+        uint32_t page = offset / pageSize;
+        uint32_t pageStart = page * pageSize;
+        uint32_t pageEnd = (end < pageStart + pageSize) ? end
+                                                        : pageStart + pageSize;
+        uint32_t lastRow = (pageEnd - 1 - pageStart) / rowBytes;
+        lastRow = (lastRow < gHeight) ? lastRow : gHeight - 1;
+
+        // Bytes past the last row of a smaller pixel format are not shown
+        uint64_t *dirty = &dirtyRows[page * rowWords];
+        for (uint32_t row = (offset - pageStart) / rowBytes; row <= lastRow;
+             row++) {
+            dirty[row / 64] |= (uint64_t)1 << (row % 64);
+        }
+
+        offset = pageEnd;
+    }
+}
+
+void VideoMemoryDevice::markAllDirty() {
+    memset(dirtyRows.data(), 0xff, dirtyRows.size() * sizeof(uint64_t));
+}
+
+void VideoMemoryDevice::expandRow(uint32_t page, uint32_t row) {
+    uint32_t *dst = &frame[row * gWidth];
+    uint32_t x = 0;
+
+    if (mem[VIDEO_MODE_OFFSET] == GRAPHICS_MODE_RGB565) {
+        const uint16_t *src =
+            (const uint16_t *)getPixelBuffer(page) + row * gWidth;
+#if defined(__SSE2__)
+        // 8 pixels per iteration, channels are widened by replicating
+        // their high bits into the low bits
+        const __m128i mask5 = _mm_set1_epi16(0x1f);
+        const __m128i mask6 = _mm_set1_epi16(0x3f);
+        const __m128i alpha = _mm_set1_epi16((short)0xff00);
+        for (; x + 8 <= gWidth; x += 8) {
+            __m128i p = _mm_loadu_si128((const __m128i *)&src[x]);
+            __m128i r = _mm_srli_epi16(p, 11);
+            __m128i g = _mm_and_si128(_mm_srli_epi16(p, 5), mask6);
+            __m128i b = _mm_and_si128(p, mask5);
+            r = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+            g = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4));
+            b = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+            __m128i rg = _mm_or_si128(r, _mm_slli_epi16(g, 8));
+            __m128i ba = _mm_or_si128(b, alpha);
+            _mm_storeu_si128((__m128i *)&dst[x], _mm_unpacklo_epi16(rg, ba));
+            _mm_storeu_si128((__m128i *)&dst[x + 4],
+                             _mm_unpackhi_epi16(rg, ba));
+        }
+#endif
+        for (; x < gWidth; x++) {
+            uint32_t r = (src[x] >> 11) & 0x1f;
+            uint32_t g = (src[x] >> 5) & 0x3f;
+            uint32_t b = src[x] & 0x1f;
+            r = (r << 3) | (r >> 2);
+            g = (g << 2) | (g >> 4);
+            b = (b << 3) | (b >> 2);
+            dst[x] = 0xff000000 | (b << 16) | (g << 8) | r;
+        }
+    } else if (mem[VIDEO_MODE_OFFSET] == GRAPHICS_MODE_INDEXED) {
+        // Palette lookups are gathers, unrolled rather than vectorized
+        const uint8_t *src = getPixelBuffer(page) + row * gWidth;
+        const uint32_t *palette = (const uint32_t *)&mem[paletteOffset];
+        for (; x + 4 <= gWidth; x += 4) {
+            dst[x] = palette[src[x]];
+            dst[x + 1] = palette[src[x + 1]];
+            dst[x + 2] = palette[src[x + 2]];
+            dst[x + 3] = palette[src[x + 3]];
+        }
+        for (; x < gWidth; x++) {
+            dst[x] = palette[src[x]];
+        }
+    }
+}
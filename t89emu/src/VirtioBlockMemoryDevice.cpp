@@ -0,0 +1,387 @@
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "VirtioBlockMemoryDevice.h"
+
+VirtioBlockMemoryDevice::VirtioBlockMemoryDevice(uint32_t base, uint32_t size,
+                                                 Bus *bus,
+                                                 PlicMemoryDevice *plic,
+                                                 uint32_t irq)
+    : MemoryDevice::MemoryDevice(base, size),
+      bus(bus),
+      plic(plic),
+      irq(irq),
+      image(nullptr),
+      imageSize(0),
+      isReadOnly(false),
+      isCopyOnWrite(false) {
+    reset();
+}
+
+VirtioBlockMemoryDevice::~VirtioBlockMemoryDevice() {
+    if (image) {
+        munmap(image, imageSize);
+    }
+}
+
+uint32_t VirtioBlockMemoryDevice::read(uint32_t addr, uint32_t size,
+                                       uint32_t *readValue) {
+    // Check memory access is aligned
+    if (!checkAlignment(addr, size)) {
+        return LOAD_ADDRESS_MISALIGNED;
+    }
+
+    switch (size) {
+    case BYTE: *readValue = *((uint8_t *)getAddress(addr)); break;
+    case HALFWORD: *readValue = *((uint16_t *)getAddress(addr)); break;
+    case WORD: *readValue = *((uint32_t *)getAddress(addr)); break;
+    }
+
+    return STATUS_OK;
+}
+
+uint32_t VirtioBlockMemoryDevice::write(uint32_t addr, uint32_t value,
+                                        uint32_t size) {
+    // Check memory access is aligned
+    if (!checkAlignment(addr, size)) {
+        return STORE_ADDRESS_MISALIGNED;
+    }
+
+    // Drivers must use 32-bit accesses for the control registers, and the
+    // configuration space of the block device is read only
+    uint32_t offset = addr - baseAddress;
+    if (size != WORD || offset >= VIRTIO_MMIO_CONFIG) {
+        return STATUS_OK;
+    }
+
+    uint32_t queueSel = *getRegister(VIRTIO_MMIO_QUEUE_SEL);
+    uint32_t featuresSel;
+    uint64_t features;
+
+    switch (offset) {
+    case VIRTIO_MMIO_DEVICE_FEATURES_SEL:
+        *getRegister(offset) = value;
+        features = getDeviceFeatures();
+        *getRegister(VIRTIO_MMIO_DEVICE_FEATURES) =
+            (value == 0) ? (uint32_t)features :
+            (value == 1) ? (uint32_t)(features >> 32) : 0;
+        break;
+    case VIRTIO_MMIO_DRIVER_FEATURES:
+        featuresSel = *getRegister(VIRTIO_MMIO_DRIVER_FEATURES_SEL);
+        if (featuresSel < 2) {
+            driverFeatures &= ~((uint64_t)0xffffffff << (32 * featuresSel));
+            driverFeatures |= (uint64_t)value << (32 * featuresSel);
+        }
+        *getRegister(offset) = value;
+        break;
+    case VIRTIO_MMIO_DRIVER_FEATURES_SEL:
+        *getRegister(offset) = value;
+        break;
+    case VIRTIO_MMIO_QUEUE_SEL:
+        *getRegister(offset) = value;
+        *getRegister(VIRTIO_MMIO_QUEUE_NUM_MAX) =
+            (value == 0) ? VIRTIO_BLK_QUEUE_SIZE : 0;
+        break;
+    case VIRTIO_MMIO_QUEUE_NUM:
+        // Split virtqueues have a power of two size, ring slots are found
+        // with free running 16 bit indices modulo the size
+        if (queueSel == 0 && value && !(value & (value - 1)) &&
+            value <= VIRTIO_BLK_QUEUE_SIZE) {
+            *getRegister(offset) = value;
+        }
+        break;
+    case VIRTIO_MMIO_QUEUE_READY:
+    case VIRTIO_MMIO_QUEUE_DESC_LOW:
+    case VIRTIO_MMIO_QUEUE_DESC_HIGH:
+    case VIRTIO_MMIO_QUEUE_DRIVER_LOW:
+    case VIRTIO_MMIO_QUEUE_DRIVER_HIGH:
+    case VIRTIO_MMIO_QUEUE_DEVICE_LOW:
+    case VIRTIO_MMIO_QUEUE_DEVICE_HIGH:
+        if (queueSel == 0) {
+            *getRegister(offset) = value;
+        }
+        break;
+    case VIRTIO_MMIO_QUEUE_NOTIFY:
+        if (value == 0) {
+            processQueue();
+        }
+        break;
+    case VIRTIO_MMIO_INTERRUPT_ACK:
+        *getRegister(VIRTIO_MMIO_INTERRUPT_STATUS) &= ~value;
+        break;
+    case VIRTIO_MMIO_STATUS:
+        if (value == 0) { // Writing zero requests a device reset
+            reset();
+            break;
+        }
+        // Refuse drivers that did not accept the modern interface
+        if ((value & VIRTIO_STATUS_FEATURES_OK) &&
+            !((driverFeatures >> VIRTIO_F_VERSION_1) & 0x1)) {
+            value &= ~VIRTIO_STATUS_FEATURES_OK;
+        }
+        *getRegister(offset) = value;
+        break;
+    default: // Read only registers
+        break;
+    }
+
+    return STATUS_OK;
+}
+
+bool VirtioBlockMemoryDevice::attachImage(const char *path,
+                                          bool isCopyOnWrite) {
+    int fd = isCopyOnWrite ? -1 : open(path, O_RDWR);
+    isReadOnly = false;
+    if (fd < 0) { // Fall back to a read only file
+        fd = open(path, O_RDONLY);
+        isReadOnly = !isCopyOnWrite;
+    }
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) || st.st_size < VIRTIO_BLK_SECTOR_SIZE) {
+        close(fd);
+        return false;
+    }
+
+    // Requests copy straight between the mapping and guest memory, the
+    // page cache does the actual file I/O. A private mapping copies pages
+    // on the first write instead, and is copied again by fork()
+    int prot = isReadOnly ? PROT_READ : (PROT_READ | PROT_WRITE);
+    int flags = isCopyOnWrite ? MAP_PRIVATE : MAP_SHARED;
+    void *mapping = mmap(NULL, st.st_size, prot, flags, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    if (image) {
+        munmap(image, imageSize);
+    }
+    image = (uint8_t *)mapping;
+    imageSize = st.st_size;
+    this->isCopyOnWrite = isCopyOnWrite;
+
+    reset();
+    return true;
+}
+
+void VirtioBlockMemoryDevice::saveState(std::vector<uint8_t> &state) {
+    MemoryDevice::saveState(state);
+    appendState(state, driverFeatures);
+    appendState(state, lastAvailIdx);
+    appendState(state, usedIdx);
+}
+
+void VirtioBlockMemoryDevice::restoreState(
+    const std::vector<uint8_t> &state) {
+    MemoryDevice::restoreState(state);
+    size_t offset = deviceSize;
+    loadState(state, &offset, &driverFeatures);
+    loadState(state, &offset, &lastAvailIdx);
+    loadState(state, &offset, &usedIdx);
+}
+
+void VirtioBlockMemoryDevice::reset() {
+    memset(mem, 0, deviceSize);
+
+    *getRegister(VIRTIO_MMIO_MAGIC_VALUE) = VIRTIO_MMIO_MAGIC;
+    *getRegister(VIRTIO_MMIO_VERSION) = 2;
+    *getRegister(VIRTIO_MMIO_DEVICE_ID) =
+        image ? VIRTIO_ID_BLOCK : VIRTIO_ID_NONE;
+    *getRegister(VIRTIO_MMIO_VENDOR_ID) = VIRTIO_MMIO_VENDOR;
+    *getRegister(VIRTIO_MMIO_DEVICE_FEATURES) = (uint32_t)getDeviceFeatures();
+    *getRegister(VIRTIO_MMIO_QUEUE_NUM_MAX) = VIRTIO_BLK_QUEUE_SIZE;
+
+    // Capacity in 512-byte sectors
+    *((uint64_t *)getRegister(VIRTIO_MMIO_CONFIG)) =
+        imageSize / VIRTIO_BLK_SECTOR_SIZE;
+
+    driverFeatures = 0;
+    lastAvailIdx = 0;
+    usedIdx = 0;
+}
+
+void VirtioBlockMemoryDevice::processQueue() {
+    uint32_t queueNum = *getRegister(VIRTIO_MMIO_QUEUE_NUM);
+    uint32_t availRing = *getRegister(VIRTIO_MMIO_QUEUE_DRIVER_LOW);
+    uint32_t usedRing = *getRegister(VIRTIO_MMIO_QUEUE_DEVICE_LOW);
+
+    // Rings must be live and reachable by a 32-bit bus
+    if (!image || !*getRegister(VIRTIO_MMIO_QUEUE_READY) || !queueNum ||
+        *getRegister(VIRTIO_MMIO_QUEUE_DRIVER_HIGH) ||
+        *getRegister(VIRTIO_MMIO_QUEUE_DEVICE_HIGH) ||
+        *getRegister(VIRTIO_MMIO_QUEUE_DESC_HIGH)) {
+        return;
+    }
+
+    uint16_t availIdx;
+    if (bus->readBlock(availRing + 2, (uint8_t *)&availIdx, 2) != STATUS_OK) {
+        return;
+    }
+
+    bool didComplete = false;
+    while (lastAvailIdx != availIdx) {
+        uint16_t head;
+        uint32_t slot = availRing + 4 + 2 * (lastAvailIdx % queueNum);
+        if (bus->readBlock(slot, (uint8_t *)&head, 2) != STATUS_OK) {
+            break;
+        }
+
+        VirtqUsedElem elem = {head, 0};
+        processRequest(head, &elem.len);
+
+        slot = usedRing + 4 + sizeof(VirtqUsedElem) * (usedIdx % queueNum);
+        bus->writeBlock(slot, (const uint8_t *)&elem, sizeof(VirtqUsedElem));
+
+        lastAvailIdx++;
+        usedIdx++;
+        didComplete = true;
+    }
+
+    if (!didComplete) {
+        return;
+    }
+
+    // Publish the used index only after the ring entries are written
+    bus->writeBlock(usedRing + 2, (const uint8_t *)&usedIdx, 2);
+
+    *getRegister(VIRTIO_MMIO_INTERRUPT_STATUS) |= VIRTIO_MMIO_INT_VRING;
+    plic->raiseInterrupt(irq);
+}
+
+void VirtioBlockMemoryDevice::processRequest(uint16_t head,
+                                             uint32_t *written) {
+    uint32_t queueNum = *getRegister(VIRTIO_MMIO_QUEUE_NUM);
+    uint32_t descTable = *getRegister(VIRTIO_MMIO_QUEUE_DESC_LOW);
+
+    // Walk the descriptor chain: header, data buffers, status byte
+    VirtqDesc chain[VIRTIO_BLK_QUEUE_SIZE];
+    uint32_t numDesc = 0;
+    uint16_t idx = head;
+    for (;;) {
+        // Chains longer than the queue must contain a loop
+        if (idx >= queueNum || numDesc == queueNum) {
+            return;
+        }
+
+        VirtqDesc &desc = chain[numDesc++];
+        if (bus->readBlock(descTable + sizeof(VirtqDesc) * idx,
+                           (uint8_t *)&desc, sizeof(VirtqDesc)) != STATUS_OK ||
+            (desc.addr >> 32)) {
+            return;
+        }
+
+        if (!(desc.flags & VIRTQ_DESC_F_NEXT)) {
+            break;
+        }
+        idx = desc.next;
+    }
+
+    VirtqDesc &statusDesc = chain[numDesc - 1];
+    if (numDesc < 2 || !(statusDesc.flags & VIRTQ_DESC_F_WRITE) ||
+        !statusDesc.len) {
+        return;
+    }
+
+    VirtioBlkReqHeader header;
+    uint8_t status;
+    if (chain[0].len < sizeof(header) ||
+        bus->readBlock(chain[0].addr, (uint8_t *)&header, sizeof(header)) !=
+            STATUS_OK) {
+        status = VIRTIO_BLK_S_IOERR;
+    } else {
+        switch (header.type) {
+        case VIRTIO_BLK_T_IN:
+        case VIRTIO_BLK_T_OUT:
+            status = transferData(header.type, header.sector, &chain[1],
+                                  numDesc - 2, written);
+            break;
+        case VIRTIO_BLK_T_FLUSH:
+            status = (isReadOnly || isCopyOnWrite ||
+                      !msync(image, imageSize, MS_SYNC))
+                         ? VIRTIO_BLK_S_OK : VIRTIO_BLK_S_IOERR;
+            break;
+        case VIRTIO_BLK_T_GET_ID:
+            status = writeId(&chain[1], numDesc - 2, written);
+            break;
+        default:
+            status = VIRTIO_BLK_S_UNSUPP;
+            break;
+        }
+    }
+
+    if (bus->writeBlock(statusDesc.addr, &status, 1) == STATUS_OK) {
+        (*written)++;
+    }
+}
+
+uint8_t VirtioBlockMemoryDevice::transferData(uint32_t type, uint64_t sector,
+                                              VirtqDesc *data,
+                                              uint32_t numData,
+                                              uint32_t *written) {
+    if (type == VIRTIO_BLK_T_OUT && isReadOnly) {
+        return VIRTIO_BLK_S_IOERR;
+    }
+
+    uint64_t offset = sector * VIRTIO_BLK_SECTOR_SIZE;
+    for (uint32_t i = 0; i < numData; i++) {
+        VirtqDesc &desc = data[i];
+        bool isDeviceWritable = desc.flags & VIRTQ_DESC_F_WRITE;
+        if (offset > imageSize || desc.len > imageSize - offset ||
+            isDeviceWritable != (type == VIRTIO_BLK_T_IN)) {
+            return VIRTIO_BLK_S_IOERR;
+        }
+
+        // Copy directly between the host mapping and guest memory
+        uint32_t status;
+        if (type == VIRTIO_BLK_T_IN) {
+            status = bus->writeBlock(desc.addr, image + offset, desc.len);
+            *written += (status == STATUS_OK) ? desc.len : 0;
+        } else {
+            status = bus->readBlock(desc.addr, image + offset, desc.len);
+        }
+        if (status != STATUS_OK) {
+            return VIRTIO_BLK_S_IOERR;
+        }
+
+        offset += desc.len;
+    }
+
+    return VIRTIO_BLK_S_OK;
+}
+
+uint8_t VirtioBlockMemoryDevice::writeId(VirtqDesc *data, uint32_t numData,
+                                         uint32_t *written) {
+    uint8_t id[VIRTIO_BLK_ID_BYTES] = "t89emu-virtio-blk";
+    if (!numData || !(data[0].flags & VIRTQ_DESC_F_WRITE)) {
+        return VIRTIO_BLK_S_IOERR;
+    }
+
+    uint32_t len = (data[0].len < VIRTIO_BLK_ID_BYTES) ? data[0].len
+                                                        : VIRTIO_BLK_ID_BYTES;
+    if (bus->writeBlock(data[0].addr, id, len) != STATUS_OK) {
+        return VIRTIO_BLK_S_IOERR;
+    }
+
+    *written += len;
+    return VIRTIO_BLK_S_OK;
+}
+
+uint64_t VirtioBlockMemoryDevice::getDeviceFeatures() {
+    uint64_t features = ((uint64_t)1 << VIRTIO_F_VERSION_1) |
+                        ((uint64_t)1 << VIRTIO_BLK_F_FLUSH);
+    if (isReadOnly) {
+        features |= ((uint64_t)1 << VIRTIO_BLK_F_RO);
+    }
+    return features;
+}
+
+uint32_t *VirtioBlockMemoryDevice::getRegister(uint32_t offset) {
+    return (uint32_t *)&mem[offset];
+}
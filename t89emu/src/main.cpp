@@ -1,18 +1,50 @@
+#include <cstring>
 #include <iostream>
 
+#include "Debugger.h"
 #include "Dwarf/DwarfParser.h"
 #include "ElfParser.h"
 #include "Gui.h"
 #include "Mcu.h"
-#include "McuDebug.h"
 
 int main(int argc, char **argv) {
-    if (argc != 2) {
+    // Optional input log to record (-r) or replay (-p), see InputLog.h
+    const char *recordPath = nullptr;
+    const char *replayPath = nullptr;
+    int arg = 1;
+    for (; arg + 1 < argc && argv[arg][0] == '-'; arg += 2) {
+        if (!strcmp(argv[arg], "-r")) {
+            recordPath = argv[arg + 1];
+        } else if (!strcmp(argv[arg], "-p")) {
+            replayPath = argv[arg + 1];
+        } else {
+            break;
+        }
+    }
+
+    int numPositional = argc - arg;
+    if ((numPositional != 1 && numPositional != 2) ||
+        (recordPath && replayPath)) {
         std::cerr << "Invalid Arguments\n";
         exit(EXIT_FAILURE);
     }
 
-    McuDebug *debug = McuDebug::getInstance(argv[1]);
+    Debugger *debug = new Debugger(argv[arg]);
+
+    // Optional disk image backing the virtio block device
+    if (numPositional == 2) {
+        ASSERT(debug->getVirtioBlockDevice()->attachImage(argv[arg + 1]),
+               "main.cpp: could not attach disk image\n");
+    }
+    debug->markLoaded();
+
+    if (recordPath) {
+        ASSERT(debug->getInputLog()->record(recordPath),
+               "main.cpp: could not create input log\n");
+    } else if (replayPath) {
+        ASSERT(debug->getInputLog()->replay(replayPath),
+               "main.cpp: could not open input log\n");
+    }
 
     Gui *emulator = new Gui(debug);
     emulator->runApplication();
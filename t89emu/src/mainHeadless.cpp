@@ -0,0 +1,293 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "BatchRunner.h"
+#include "CodeCoverage.h"
+#include "ForkServer.h"
+#include "InputLog.h"
+#include "Machine.h"
+#include "Mcu.h"
+#include "Runner.h"
+
+struct HeadlessOptions {
+    const char *elfPath = nullptr;
+    const char *diskPath = nullptr;
+    const char *keyScriptPath = nullptr;
+    const char *recordPath = nullptr;
+    const char *replayPath = nullptr;
+    const char *lcovPath = nullptr;
+    uint32_t numHarts = 1;
+    RunOptions run;
+
+    // Batch mode
+    const char *manifestPath = nullptr;
+    const char *reportPath = "-";
+    uint32_t numWorkers = 0;        // One per host core if 0
+
+    // Fork server mode, addresses are hex or symbol names
+    const char *forkStart = nullptr;
+    const char *forkInput = nullptr;
+    uint32_t forkInputSize = 4096;
+    const char *forkInputPath = nullptr;
+};
+
+static void printUsage(void) {
+    std::cerr
+        << "Usage: t89emu-headless [options] <elf> [disk image]\n"
+        << "       t89emu-headless [options] -m <manifest>\n"
+        << "  -n <count>    Stop after count instructions (per hart)\n"
+        << "  -t <seconds>  Stop after a wall-clock time\n"
+        << "  -b <address>  Halt when hart 0 reaches address (hex)\n"
+        << "  -l            Halt when hart 0 jumps to itself\n"
+        << "  -k <script>   Keyboard script, see KeyboardMemoryDevice\n"
+        << "  -r <log>      Record host inputs, see InputLog.h\n"
+        << "  -p <log>      Replay host inputs recorded with -r\n"
+        << "  -c <lcov>     Write line coverage of ROM code as lcov\n"
+        << "  -j <harts>    Number of harts, each on its own thread\n"
+        << "  -q <quantum>  Run all harts on one thread, interleaved\n"
+        << "  -m <manifest> Run every job of a manifest, see BatchRunner.h\n"
+        << "  -w <workers>  Jobs run at once in batch mode (default: cores)\n"
+        << "  -o <report>   Batch JSON report path (default: stdout)\n"
+        << "  -F <start>    Fork server, boot to start and fork per input\n"
+        << "  -I <buffer>   Guest buffer test inputs are copied to\n"
+        << "  -z <size>     Capacity of the input buffer (default: 4096)\n"
+        << "  -i <input>    Test input file (default: stdin)\n"
+        << "Halt conditions (-b, -l) and input logs (-r, -p) need a single\n"
+        << "hart or -q, other runs are not deterministic. The run ends\n"
+        << "when firmware exits through the semihosting device. In batch\n"
+        << "mode -n, -t and -q are defaults for jobs that do not set them.\n"
+        << "Fork server addresses (-F, -I) are hex or symbol names, see\n"
+        << "ForkServer.h\n";
+}
+
+static HeadlessOptions parseOptions(int argc, char **argv) {
+    HeadlessOptions options;
+    int positional = 0;
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        if (arg[0] == '-' && arg[1] && !arg[2]) {
+            if (arg[1] == 'l') {
+                options.run.isHaltOnLoop = true;
+                continue;
+            }
+
+            if (i + 1 >= argc) {
+                printUsage();
+                exit(EXIT_FAILURE);
+            }
+            const char *value = argv[++i];
+            switch (arg[1]) {
+            case 'n':
+                options.run.maxInstructions = strtoull(value, nullptr, 0);
+                break;
+            case 't': options.run.maxSeconds = strtod(value, nullptr); break;
+            case 'b':
+                options.run.hasHaltAddress = true;
+                options.run.haltAddress = strtoul(value, nullptr, 16);
+                break;
+            case 'k': options.keyScriptPath = value; break;
+            case 'r': options.recordPath = value; break;
+            case 'p': options.replayPath = value; break;
+            case 'c': options.lcovPath = value; break;
+            case 'j': options.numHarts = strtoul(value, nullptr, 0); break;
+            case 'q': options.run.quantum = strtoul(value, nullptr, 0); break;
+            case 'm': options.manifestPath = value; break;
+            case 'w': options.numWorkers = strtoul(value, nullptr, 0); break;
+            case 'o': options.reportPath = value; break;
+            case 'F': options.forkStart = value; break;
+            case 'I': options.forkInput = value; break;
+            case 'z': options.forkInputSize = strtoul(value, nullptr, 0); break;
+            case 'i': options.forkInputPath = value; break;
+            default:
+                printUsage();
+                exit(EXIT_FAILURE);
+            }
+        } else if (positional == 0) {
+            options.elfPath = arg;
+            positional++;
+        } else if (positional == 1) {
+            options.diskPath = arg;
+            positional++;
+        } else {
+            printUsage();
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    bool hasHaltCondition =
+        options.run.hasHaltAddress || options.run.isHaltOnLoop;
+    bool hasInputLog = options.recordPath || options.replayPath;
+    if (options.manifestPath) {
+        if (options.elfPath) {
+            printUsage();
+            exit(EXIT_FAILURE);
+        }
+        return options;
+    }
+
+    if (!options.elfPath || options.numHarts == 0 ||
+        options.numHarts > CLINT_MAX_HARTS ||
+        ((hasHaltCondition || hasInputLog) && options.numHarts != 1 &&
+         !options.run.quantum) ||
+        (options.forkStart && (!options.forkInput || hasHaltCondition)) ||
+        (options.recordPath && options.replayPath) ||
+        (options.forkStart && (options.recordPath || options.replayPath ||
+                               options.lcovPath))) {
+        printUsage();
+        exit(EXIT_FAILURE);
+    }
+
+    return options;
+}
+
+// Run every job of the manifest and report the results. Fails unless every
+// job exits through semihosting with code 0
+static int runBatch(const HeadlessOptions &options) {
+    BatchRunner batch(options.numWorkers);
+    if (!batch.loadManifest(options.manifestPath, options.run)) {
+        return EXIT_FAILURE;
+    }
+
+    batch.run();
+    if (!batch.writeReport(options.reportPath)) {
+        return EXIT_FAILURE;
+    }
+
+    return batch.getNumFailed() ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+// Address of a symbol, or a hex address if there is no such symbol
+static bool resolveAddress(ElfParser *elfParser, const char *value,
+                           uint32_t *address) {
+    if (elfParser->getSymbolAddress(value, address)) {
+        return true;
+    }
+
+    char *end;
+    *address = strtoul(value, &end, 16);
+    return *value && !*end;
+}
+
+// Boot once to the start point, then serve the fuzzer, see ForkServer.h
+static int runForkServer(const HeadlessOptions &options, Machine *machine) {
+    ForkServerOptions forkOptions;
+    forkOptions.inputSize = options.forkInputSize;
+    forkOptions.inputPath = options.forkInputPath;
+    forkOptions.run = options.run;
+
+    ElfParser *elfParser = machine->getElfParser();
+    if (!resolveAddress(elfParser, options.forkStart, &forkOptions.startPc) ||
+        !resolveAddress(elfParser, options.forkInput,
+                        &forkOptions.inputAddress)) {
+        std::cerr << "mainHeadless.cpp: unknown fork server address\n";
+        return EXIT_FAILURE;
+    }
+
+    ForkServer server(machine, forkOptions);
+    if (!server.boot(options.run.maxInstructions)) {
+        std::cerr << "mainHeadless.cpp: firmware did not reach the start\n";
+        return EXIT_FAILURE;
+    }
+
+    return server.serve();
+}
+
+int main(int argc, char **argv) {
+    HeadlessOptions options = parseOptions(argc, argv);
+    if (options.manifestPath) {
+        return runBatch(options);
+    }
+
+    Machine *machine = new Machine(options.elfPath, options.numHarts);
+    Smp *smp = machine->getSmp();
+    Mcu *mcu = machine->getMcu();
+
+    // Optional disk image backing the virtio block device. Fork server
+    // children write to their own copy, so one test case cannot change the
+    // disk that the next one boots from
+    if (options.diskPath) {
+        ASSERT(mcu->getVirtioBlockDevice()->attachImage(
+                   options.diskPath, options.forkStart != nullptr),
+               "mainHeadless.cpp: could not attach disk image\n");
+    }
+
+    if (options.keyScriptPath) {
+        ASSERT(mcu->getKeyboardDevice()->loadScript(options.keyScriptPath),
+               "mainHeadless.cpp: could not load keyboard script\n");
+    }
+
+    if (options.forkStart) {
+        int exitStatus = runForkServer(options, machine);
+        delete machine;
+        return exitStatus;
+    }
+
+    InputLog *inputLog = new InputLog(mcu);
+    if (options.recordPath) {
+        ASSERT(inputLog->record(options.recordPath),
+               "mainHeadless.cpp: could not create input log\n");
+    } else if (options.replayPath) {
+        ASSERT(inputLog->replay(options.replayPath),
+               "mainHeadless.cpp: could not open input log\n");
+    }
+
+    CodeCoverage *coverage =
+        options.lcovPath ? new CodeCoverage(smp) : nullptr;
+
+    Runner runner(smp, options.run);
+    RunResult result = runner.run();
+
+    // Run statistics
+    printf("stop reason:   %s\n", result.reason);
+    for (uint32_t hartId = 0; hartId < options.numHarts; hartId++) {
+        printf("hart %u:        %llu instructions, pc %08x\n", hartId,
+               (unsigned long long)result.hartInstructions[hartId],
+               smp->getHart(hartId)->getProgramCounterModule()->getPc());
+    }
+    printf("instructions:  %llu\n", (unsigned long long)result.instructions);
+    printf("elapsed:       %.3f s\n", result.seconds);
+    printf("MIPS:          %.2f\n",
+           result.seconds ? result.instructions / result.seconds / 1e6 : 0.0);
+
+    // The guest's exit code becomes the exit status of the run. The host
+    // only keeps its low 8 bits, so codes like 256 must not turn into 0
+    SemihostMemoryDevice *semihost = mcu->getSemihostDevice();
+    int exitStatus = EXIT_SUCCESS;
+    if (semihost->hasExited()) {
+        uint32_t exitCode = semihost->getExitCode();
+        exitStatus = (exitCode & 0xff) || !exitCode ? (int)(exitCode & 0xff)
+                                                    : EXIT_FAILURE;
+        printf("exit code:     %u\n", exitCode);
+    }
+
+    if (inputLog->isReplaying() && inputLog->hasDiverged()) {
+        printf("replay:        diverged\n");
+        exitStatus = EXIT_FAILURE;
+    }
+
+    if (coverage) {
+        if (!coverage->writeLcov(options.elfPath, options.lcovPath)) {
+            exitStatus = EXIT_FAILURE;
+        }
+        delete coverage;
+    }
+
+    Mmu *mmu = mcu->getMmuModule();
+    uint64_t hits = mmu->getTlbHits(ACCESS_FETCH) +
+                    mmu->getTlbHits(ACCESS_LOAD) +
+                    mmu->getTlbHits(ACCESS_STORE);
+    uint64_t misses = mmu->getTlbMisses(ACCESS_FETCH) +
+                      mmu->getTlbMisses(ACCESS_LOAD) +
+                      mmu->getTlbMisses(ACCESS_STORE);
+    if (hits + misses) {
+        printf("hart 0 TLB:    %llu hits, %llu misses\n",
+               (unsigned long long)hits, (unsigned long long)misses);
+    }
+
+    delete inputLog;
+    delete machine;
+    return exitStatus;
+}
@@ -0,0 +1,325 @@
+#include <atomic>
+#include <unordered_set>
+
+#include "Machine.h"
+#include "t89emu.h"
+
+struct t89emu_image {
+    ElfParser *elfParser;
+};
+
+struct t89emu_machine {
+    uint32_t numHarts;
+    Machine *machine;
+    t89emu_image *ownedImage; // Image of t89emu_load_elf
+
+    // Unique per load, snapshots of other loads are rejected
+    uint64_t generation;
+
+    std::unordered_set<uint32_t> breakpoints;
+};
+
+struct t89emu_snapshot {
+    uint64_t generation;
+    Machine::Snapshot state;
+};
+
+// Source of load generations, shared by all machines
+static std::atomic<uint64_t> nextGeneration(1);
+
+// Hart of a machine with firmware, nullptr if there is none
+static Mcu *getHart(t89emu_machine *machine, uint32_t hart) {
+    if (!machine || !machine->machine || hart >= machine->numHarts) {
+        return nullptr;
+    }
+    return machine->machine->getSmp()->getHart(hart);
+}
+
+// Error of a call that was given a machine and a hart
+static int getHartError(t89emu_machine *machine) {
+    if (machine && !machine->machine) {
+        return T89EMU_ERROR_NO_FIRMWARE;
+    }
+    return T89EMU_ERROR_ARGUMENT;
+}
+
+uint32_t t89emu_api_version() {
+    return T89EMU_API_VERSION;
+}
+
+t89emu_image *t89emu_image_open(const char *path) {
+    ElfParser *elfParser = path ? ElfParser::open(path) : nullptr;
+    if (!elfParser) {
+        return nullptr;
+    }
+
+    return new t89emu_image{elfParser};
+}
+
+void t89emu_image_close(t89emu_image *image) {
+    if (image) {
+        delete image->elfParser;
+        delete image;
+    }
+}
+
+t89emu_machine *t89emu_create(uint32_t num_harts) {
+    if (num_harts == 0 || num_harts > CLINT_MAX_HARTS) {
+        return nullptr;
+    }
+
+    return new t89emu_machine{num_harts, nullptr, nullptr, 0, {}};
+}
+
+void t89emu_destroy(t89emu_machine *machine) {
+    if (machine) {
+        delete machine->machine;
+        t89emu_image_close(machine->ownedImage);
+        delete machine;
+    }
+}
+
+int t89emu_load_elf(t89emu_machine *machine, const char *path) {
+    if (!machine) {
+        return T89EMU_ERROR_ARGUMENT;
+    }
+
+    t89emu_image *image = t89emu_image_open(path);
+    if (!image) {
+        return T89EMU_ERROR_ELF;
+    }
+
+    int status = t89emu_load_image(machine, image);
+    machine->ownedImage = image; // After the previous image was released
+    return status;
+}
+
+int t89emu_load_image(t89emu_machine *machine, t89emu_image *image) {
+    if (!machine || !image) {
+        return T89EMU_ERROR_ARGUMENT;
+    }
+
+    delete machine->machine;
+    t89emu_image_close(machine->ownedImage);
+    machine->ownedImage = nullptr;
+
+    machine->machine = new Machine(image->elfParser, machine->numHarts);
+    machine->generation = nextGeneration++;
+    machine->breakpoints.clear();
+    return T89EMU_OK;
+}
+
+int t89emu_run(t89emu_machine *machine, uint64_t budget, uint64_t *executed) {
+    if (!getHart(machine, 0)) {
+        return getHartError(machine);
+    }
+
+    Smp *smp = machine->machine->getSmp();
+    SemihostMemoryDevice *semihost = smp->getHart(0)->getSemihostDevice();
+    bool hasBreakpoints = !machine->breakpoints.empty();
+    int reason = T89EMU_STOP_BUDGET;
+    uint64_t count = 0;
+
+    while (!budget || count < budget) {
+        if (semihost->hasExited()) {
+            reason = T89EMU_STOP_EXIT;
+            break;
+        }
+
+        // Check every hart before the turn, except on the first turn so a
+        // run can continue from a breakpoint
+        if (hasBreakpoints && count) {
+            bool isBreakpoint = false;
+            for (uint32_t hartId = 0; hartId < machine->numHarts; hartId++) {
+                uint32_t pc =
+                    smp->getHart(hartId)->getProgramCounterModule()->getPc();
+                isBreakpoint |= machine->breakpoints.count(pc) != 0;
+            }
+            if (isBreakpoint) {
+                reason = T89EMU_STOP_BREAKPOINT;
+                break;
+            }
+        }
+
+        for (uint32_t hartId = 0; hartId < machine->numHarts; hartId++) {
+            smp->getHart(hartId)->nextInstruction();
+        }
+        count++;
+    }
+
+    // Exits on the last instruction of the budget still count
+    if (reason == T89EMU_STOP_BUDGET && semihost->hasExited()) {
+        reason = T89EMU_STOP_EXIT;
+    }
+    if (executed) {
+        *executed = count;
+    }
+    return reason;
+}
+
+int t89emu_get_exit_code(t89emu_machine *machine, uint32_t *exit_code) {
+    Mcu *mcu = getHart(machine, 0);
+    if (!mcu) {
+        return getHartError(machine);
+    }
+    if (!exit_code || !mcu->getSemihostDevice()->hasExited()) {
+        return T89EMU_ERROR_ARGUMENT;
+    }
+
+    *exit_code = mcu->getSemihostDevice()->getExitCode();
+    return T89EMU_OK;
+}
+
+int t89emu_read_register(t89emu_machine *machine, uint32_t hart,
+                         uint32_t reg, uint32_t *value) {
+    Mcu *mcu = getHart(machine, hart);
+    if (!mcu) {
+        return getHartError(machine);
+    }
+
+    if (!value || reg > T89EMU_REG_F0 + 31) {
+        return T89EMU_ERROR_ARGUMENT;
+    } else if (reg < T89EMU_REG_PC) {
+        *value = mcu->getRegisterFileModule()->read(reg);
+    } else if (reg == T89EMU_REG_PC) {
+        *value = mcu->getProgramCounterModule()->getPc();
+    } else {
+        FloatRegisterFile *frf = mcu->getFloatRegisterFileModule();
+        *value = frf->read(reg - T89EMU_REG_F0);
+    }
+    return T89EMU_OK;
+}
+
+int t89emu_write_register(t89emu_machine *machine, uint32_t hart,
+                          uint32_t reg, uint32_t value) {
+    Mcu *mcu = getHart(machine, hart);
+    if (!mcu) {
+        return getHartError(machine);
+    }
+
+    if (reg > T89EMU_REG_F0 + 31) {
+        return T89EMU_ERROR_ARGUMENT;
+    } else if (reg < T89EMU_REG_PC) {
+        mcu->getRegisterFileModule()->write(value, reg);
+    } else if (reg == T89EMU_REG_PC) {
+        mcu->getProgramCounterModule()->setPc(value);
+        mcu->getNextPcModule()->setNextPc(value);
+    } else {
+        FloatRegisterFile *frf = mcu->getFloatRegisterFileModule();
+        frf->write(value, reg - T89EMU_REG_F0);
+    }
+    return T89EMU_OK;
+}
+
+int t89emu_read_csr(t89emu_machine *machine, uint32_t hart, uint32_t csr,
+                    uint32_t *value) {
+    Mcu *mcu = getHart(machine, hart);
+    if (!mcu) {
+        return getHartError(machine);
+    }
+    if (!value || csr > 0xfff) {
+        return T89EMU_ERROR_ARGUMENT;
+    }
+
+    *value = mcu->getCsrModule()->readCsr(csr);
+    return T89EMU_OK;
+}
+
+int t89emu_write_csr(t89emu_machine *machine, uint32_t hart, uint32_t csr,
+                     uint32_t value) {
+    Mcu *mcu = getHart(machine, hart);
+    if (!mcu) {
+        return getHartError(machine);
+    }
+    if (csr > 0xfff) {
+        return T89EMU_ERROR_ARGUMENT;
+    }
+
+    // Same side effects as a CSR instruction
+    Csr *csrModule = mcu->getCsrModule();
+    csrModule->writeCsr(csr, value);
+    if (csrModule->isPmpCsr(csr)) {
+        mcu->getMmuModule()->getPmp()->update(csrModule);
+    }
+    mcu->getMmuModule()->update(csrModule);
+    return T89EMU_OK;
+}
+
+int t89emu_read_memory(t89emu_machine *machine, uint32_t addr, void *buf,
+                       size_t size) {
+    Mcu *mcu = getHart(machine, 0);
+    if (!mcu) {
+        return getHartError(machine);
+    }
+    if (!buf || size > UINT32_MAX) {
+        return T89EMU_ERROR_ARGUMENT;
+    }
+
+    uint32_t exceptionCode =
+        mcu->getBusModule()->readBlock(addr, (uint8_t *)buf, size);
+    return (exceptionCode == STATUS_OK) ? T89EMU_OK : T89EMU_ERROR_ACCESS;
+}
+
+int t89emu_write_memory(t89emu_machine *machine, uint32_t addr,
+                        const void *buf, size_t size) {
+    Mcu *mcu = getHart(machine, 0);
+    if (!mcu) {
+        return getHartError(machine);
+    }
+    if (!buf || size > UINT32_MAX) {
+        return T89EMU_ERROR_ARGUMENT;
+    }
+
+    uint32_t exceptionCode =
+        mcu->getBusModule()->writeBlock(addr, (const uint8_t *)buf, size);
+    return (exceptionCode == STATUS_OK) ? T89EMU_OK : T89EMU_ERROR_ACCESS;
+}
+
+int t89emu_add_breakpoint(t89emu_machine *machine, uint32_t addr) {
+    if (!getHart(machine, 0)) {
+        return getHartError(machine);
+    }
+
+    machine->breakpoints.insert(addr);
+    return T89EMU_OK;
+}
+
+int t89emu_remove_breakpoint(t89emu_machine *machine, uint32_t addr) {
+    if (!getHart(machine, 0)) {
+        return getHartError(machine);
+    }
+
+    machine->breakpoints.erase(addr);
+    return T89EMU_OK;
+}
+
+t89emu_snapshot *t89emu_snapshot_save(t89emu_machine *machine) {
+    if (!getHart(machine, 0)) {
+        return nullptr;
+    }
+
+    t89emu_snapshot *snapshot = new t89emu_snapshot;
+    snapshot->generation = machine->generation;
+    machine->machine->saveSnapshot(snapshot->state);
+    return snapshot;
+}
+
+int t89emu_snapshot_restore(t89emu_machine *machine,
+                            const t89emu_snapshot *snapshot) {
+    if (!getHart(machine, 0)) {
+        return getHartError(machine);
+    }
+    if (!snapshot) {
+        return T89EMU_ERROR_ARGUMENT;
+    }
+    if (snapshot->generation != machine->generation) {
+        return T89EMU_ERROR_SNAPSHOT;
+    }
+
+    machine->machine->restoreSnapshot(snapshot->state);
+    return T89EMU_OK;
+}
+
+void t89emu_snapshot_free(t89emu_snapshot *snapshot) {
+    delete snapshot;
+}